@@ -2,38 +2,129 @@
  * DA2Network.hpp
  * Shivang Patel (shivang2402) - 2026-01-23
  * Depth Anything V2 wrapper using ONNX Runtime.
+ *
+ * Input and output tensors are allocated once and bound to the session with
+ * Ort::IoBinding; preprocessing writes normalized planar RGB straight into
+ * the bound input, so a frame needs no heap allocation after the first.
+ *
+ * INT8 exports (onnxruntime.quantization quantize_dynamic or QDQ static
+ * quantization) load the same way as long as they keep float32 input and
+ * output, which both quantizers do by default.
  */
 
 #ifndef DA2NETWORK_HPP
 #define DA2NETWORK_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include "stageTimer.h"
 #include <onnxruntime/onnxruntime_cxx_api.h>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
 
+// Session settings that trade latency against quality
+struct DA2Config {
+  int intraThreads = 4;
+  int interThreads = 0;           // 0 = ONNX Runtime default
+  bool parallelExecution = false; // ORT_PARALLEL instead of ORT_SEQUENTIAL
+  int optLevel = 3;               // 0 none, 1 basic, 2 extended, 3 all
+  std::string optimizedModelPath; // save the optimized graph here
+  int inputSize = 0; // square input for dynamic-shape exports, 0 = 518
+  std::string model = "vits"; // vits, vits_int8, vitb or an .onnx path
+  // Depth maps stay at the model's output size instead of the frame's;
+  // digitalFog samples them directly and the resize pass is skipped
+  bool lowResOutput = false;
+
+  // File name of the model, e.g. "depth_anything_v2_vits.onnx"
+  std::string modelFile() const {
+    if (model.size() > 5 && model.compare(model.size() - 5, 5, ".onnx") == 0)
+      return model;
+    return "depth_anything_v2_" + model + ".onnx";
+  }
+
+  // modelFile() as given, or in ../data/ or data/; "" if not found
+  std::string modelPath() const {
+    std::string file = modelFile();
+    if (std::ifstream(file).good())
+      return file;
+    if (file.find('/') != std::string::npos)
+      return "";
+    for (const char *dir : {"../data/", "data/"}) {
+      if (std::ifstream(dir + file).good())
+        return dir + file;
+    }
+    return "";
+  }
+};
+
 class DA2Network {
 public:
-  DA2Network() : session_(nullptr), env_(nullptr), initialized_(false) {}
+  DA2Network()
+      : session_(nullptr), env_(nullptr), binding_(nullptr),
+        inputValue_(nullptr), outputValue_(nullptr), initialized_(false),
+        outputBound_(false), preMs_(0), inferMs_(0), postMs_(0) {}
   ~DA2Network() {
-    session_ = nullptr;
-    env_ = nullptr;
+    delete binding_;
+    delete session_;
+    delete env_;
   }
+  // owns the session and its buffers; a copy would delete them twice
+  DA2Network(const DA2Network &) = delete;
+  DA2Network &operator=(const DA2Network &) = delete;
 
-  bool init(const std::string &modelPath) {
+  bool init(const std::string &modelPath,
+            const DA2Config &config = DA2Config()) {
     try {
-      env_ = new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "DA2Network");
+      if (env_ == nullptr)
+        env_ = new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "DA2Network");
+      config_ = config;
+      static const GraphOptimizationLevel levels[4] = {
+          GraphOptimizationLevel::ORT_DISABLE_ALL,
+          GraphOptimizationLevel::ORT_ENABLE_BASIC,
+          GraphOptimizationLevel::ORT_ENABLE_EXTENDED,
+          GraphOptimizationLevel::ORT_ENABLE_ALL};
       Ort::SessionOptions opts;
-      opts.SetIntraOpNumThreads(4);
-      opts.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+      opts.SetIntraOpNumThreads(config.intraThreads);
+      if (config.interThreads > 0)
+        opts.SetInterOpNumThreads(config.interThreads);
+      opts.SetExecutionMode(config.parallelExecution
+                                ? ExecutionMode::ORT_PARALLEL
+                                : ExecutionMode::ORT_SEQUENTIAL);
+      opts.SetGraphOptimizationLevel(
+          levels[std::min(3, std::max(0, config.optLevel))]);
+      if (!config.optimizedModelPath.empty())
+        opts.SetOptimizedModelFilePath(config.optimizedModelPath.c_str());
+
+      delete binding_;
+      binding_ = nullptr;
+      delete session_;
+      session_ = nullptr;
+      initialized_ = false;
       session_ = new Ort::Session(*env_, modelPath.c_str(), opts);
 
       Ort::AllocatorWithDefaultOptions alloc;
       inputName_ = session_->GetInputNameAllocated(0, alloc).get();
       outputName_ = session_->GetOutputNameAllocated(0, alloc).get();
-      inputShape_ =
-          session_->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+      auto inInfo = session_->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo();
+      auto outInfo =
+          session_->GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo();
+      inputShape_ = inInfo.GetShape();
+      outputRank_ = outInfo.GetShape().size();
+
+      // quantized models must keep float I/O, the tensors below are float
+      if (inInfo.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT ||
+          outInfo.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        std::cerr << "DA2Network: " << modelPath
+                  << " needs float32 input and output" << std::endl;
+        delete session_;
+        session_ = nullptr;
+        return false;
+      }
+
+      bindTensors();
 
       initialized_ = true;
       std::cout << "DA2Network initialized successfully" << std::endl;
@@ -49,72 +140,228 @@ public:
   }
 
   bool isInitialized() const { return initialized_; }
+  const DA2Config &config() const { return config_; }
+  cv::Size inputSize() const { return cv::Size(inW_, inH_); }
 
   bool process(cv::Mat &src, cv::Mat &dst) {
     if (!initialized_)
       return false;
 
     try {
-      int inH = (inputShape_[2] > 0) ? inputShape_[2] : 518;
-      int inW = (inputShape_[3] > 0) ? inputShape_[3] : 518;
-
-      cv::Mat resized, floatImg;
-      cv::resize(src, resized, cv::Size(inW, inH));
-      resized.convertTo(floatImg, CV_32FC3, 1.0 / 255.0);
-      cv::cvtColor(floatImg, floatImg, cv::COLOR_BGR2RGB);
-
-      // Normalize with ImageNet mean/std
-      cv::Scalar mean(0.485, 0.456, 0.406), std(0.229, 0.224, 0.225);
-      std::vector<cv::Mat> ch;
-      cv::split(floatImg, ch);
-      for (int i = 0; i < 3; i++)
-        ch[i] = (ch[i] - mean[i]) / std[i];
-      cv::merge(ch, floatImg);
-
-      // Convert to NCHW
-      std::vector<float> tensor(3 * inH * inW);
-      for (int c = 0; c < 3; c++)
-        for (int h = 0; h < inH; h++)
-          for (int w = 0; w < inW; w++)
-            tensor[c * inH * inW + h * inW + w] =
-                floatImg.at<cv::Vec3f>(h, w)[c];
-
-      // Run inference
-      std::vector<int64_t> dims = {1, 3, inH, inW};
+      auto t0 = std::chrono::steady_clock::now();
+      preprocess(src);
+
+      auto t1 = std::chrono::steady_clock::now();
+      try {
+        session_->Run(runOptions_, *binding_);
+      } catch (const Ort::Exception &) {
+        if (!outputBound_)
+          throw;
+        // model rejected the preallocated output shape, let ORT allocate it
+        binding_->ClearBoundOutputs();
+        binding_->BindOutput(
+            outputName_.c_str(),
+            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault));
+        outputBound_ = false;
+        session_->Run(runOptions_, *binding_);
+      }
+
+      auto t2 = std::chrono::steady_clock::now();
+      int outH = inH_, outW = inW_;
+      float *data = outputTensor_.data();
+      if (!outputBound_) {
+        outputValue_ = std::move(binding_->GetOutputValues()[0]);
+        auto shape = outputValue_.GetTensorTypeAndShapeInfo().GetShape();
+        outH = shape[shape.size() - 2];
+        outW = shape[shape.size() - 1];
+        data = outputValue_.GetTensorMutableData<float>();
+      }
+
+      raw_ = cv::Mat(outH, outW, CV_32FC1, data);
+      toDepthMap(raw_, src.size(), dst);
+
+      auto t3 = std::chrono::steady_clock::now();
+      recordTimes(t0, t1, t2, t3);
+      return true;
+    } catch (...) {
+      return false;
+    }
+  }
+
+  // True if the model takes any batch size (first input dimension is -1)
+  bool dynamicBatch() const {
+    return !inputShape_.empty() && inputShape_[0] < 0;
+  }
+
+  // Runs all frames through the model as one batch of srcs.size(). Models
+  // exported with batch size 1 get the frames one at a time instead.
+  bool processBatch(std::vector<cv::Mat> &srcs, std::vector<cv::Mat> &dsts) {
+    if (!initialized_)
+      return false;
+    dsts.resize(srcs.size());
+    if (srcs.size() <= 1 || !dynamicBatch()) {
+      bool ok = true;
+      for (size_t i = 0; i < srcs.size(); i++)
+        ok = process(srcs[i], dsts[i]) && ok;
+      return ok;
+    }
+
+    try {
+      auto t0 = std::chrono::steady_clock::now();
+      int64_t n = (int64_t)srcs.size();
+      size_t per = 3 * (size_t)inH_ * inW_;
+      batchInput_.resize(n * per);
+      for (int64_t i = 0; i < n; i++)
+        preprocess(srcs[i], batchInput_.data() + i * per);
+
       auto mem =
           Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-      auto inTensor = Ort::Value::CreateTensor<float>(
-          mem, tensor.data(), tensor.size(), dims.data(), 4);
+      std::vector<int64_t> dims = {n, 3, inH_, inW_};
+      Ort::Value input = Ort::Value::CreateTensor<float>(
+          mem, batchInput_.data(), batchInput_.size(), dims.data(), 4);
       const char *inNames[] = {inputName_.c_str()};
       const char *outNames[] = {outputName_.c_str()};
-      auto out =
-          session_->Run(Ort::RunOptions{}, inNames, &inTensor, 1, outNames, 1);
 
-      // Process output
-      auto &outT = out[0];
-      auto shape = outT.GetTensorTypeAndShapeInfo().GetShape();
+      auto t1 = std::chrono::steady_clock::now();
+      auto outputs =
+          session_->Run(runOptions_, inNames, &input, 1, outNames, 1);
+
+      auto t2 = std::chrono::steady_clock::now();
+      auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
       int outH = shape[shape.size() - 2], outW = shape[shape.size() - 1];
-      float *data = outT.GetTensorMutableData<float>();
-
-      cv::Mat depth(outH, outW, CV_32FC1, data);
-      double minV, maxV;
-      cv::minMaxLoc(depth, &minV, &maxV);
-      cv::Mat norm;
-      depth.convertTo(norm, CV_8UC1, 255.0 / (maxV - minV),
-                      -minV * 255.0 / (maxV - minV));
-      cv::resize(norm, dst, src.size());
+      float *data = outputs[0].GetTensorMutableData<float>();
+      for (int64_t i = 0; i < n; i++) {
+        cv::Mat depth(outH, outW, CV_32FC1, data + i * outH * outW);
+        toDepthMap(depth, srcs[i].size(), dsts[i]);
+      }
+
+      auto t3 = std::chrono::steady_clock::now();
+      recordTimes(t0, t1, t2, t3);
       return true;
     } catch (...) {
       return false;
     }
   }
 
+  // Milliseconds spent in each part of the last process() call
+  double preprocessMs() const { return preMs_; }
+  double inferenceMs() const { return inferMs_; }
+  double postprocessMs() const { return postMs_; }
+
+  // Model output of the last process() call before normalization, at the
+  // model's resolution. Points into the output tensor, so it is overwritten
+  // by the next call; clone it to keep it.
+  const cv::Mat &rawDepth() const { return raw_; }
+
 private:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  // Keeps the last call's stage times and feeds the stage histograms
+  void recordTimes(TimePoint t0, TimePoint t1, TimePoint t2, TimePoint t3) {
+    preMs_ = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    inferMs_ = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    postMs_ = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    recordStageMs(Stage::DepthPre, preMs_);
+    recordStageMs(Stage::DepthInfer, inferMs_);
+    recordStageMs(Stage::DepthPost, postMs_);
+  }
+
+  void bindTensors() {
+    // dynamic-shape exports take any multiple of the 14-pixel ViT patch
+    int dynSize = config_.inputSize > 0 ? config_.inputSize : 518;
+    dynSize = std::max(14, dynSize / 14 * 14);
+    bool fixed = inputShape_.size() == 4 && inputShape_[2] > 0 &&
+                 inputShape_[3] > 0;
+    inH_ = fixed ? inputShape_[2] : dynSize;
+    inW_ = fixed ? inputShape_[3] : dynSize;
+    if (fixed && config_.inputSize > 0 && config_.inputSize != inW_)
+      std::cerr << "Model input is fixed at " << inW_ << "x" << inH_
+                << ", ignoring input size " << config_.inputSize << std::endl;
+    inputTensor_.assign(3 * (size_t)inH_ * inW_, 0.0f);
+    outputTensor_.assign((size_t)inH_ * inW_, 0.0f);
+
+    auto mem =
+        Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    std::vector<int64_t> inDims = {1, 3, inH_, inW_};
+    inputValue_ = Ort::Value::CreateTensor<float>(
+        mem, inputTensor_.data(), inputTensor_.size(), inDims.data(), 4);
+
+    delete binding_;
+    binding_ = new Ort::IoBinding(*session_);
+    binding_->BindInput(inputName_.c_str(), inputValue_);
+
+    // Depth Anything outputs (1, H, W) or (1, 1, H, W) at the input size
+    std::vector<int64_t> outDims = {1, inH_, inW_};
+    if (outputRank_ == 4)
+      outDims.insert(outDims.begin() + 1, 1);
+    outputValue_ = Ort::Value::CreateTensor<float>(
+        mem, outputTensor_.data(), outputTensor_.size(), outDims.data(),
+        outDims.size());
+    binding_->BindOutput(outputName_.c_str(), outputValue_);
+    outputBound_ = true;
+  }
+
+  // Min-max normalizes the model output to 8 bits at the frame size, or
+  // at the model's size with lowResOutput
+  void toDepthMap(const cv::Mat &depth, cv::Size size, cv::Mat &dst) {
+    double minV, maxV;
+    cv::minMaxLoc(depth, &minV, &maxV);
+    double range = (maxV - minV) > 1e-6 ? (maxV - minV) : 1.0;
+    double scale = 255.0 / range, shift = -minV * 255.0 / range;
+    if (config_.lowResOutput) {
+      depth.convertTo(dst, CV_8UC1, scale, shift);
+      return;
+    }
+    depth.convertTo(norm_, CV_8UC1, scale, shift);
+    cv::resize(norm_, dst, size);
+  }
+
+  // Resize, BGR->RGB, /255, ImageNet mean/std and HWC->CHW in one pass,
+  // written straight into the bound input tensor (or one batch entry)
+  void preprocess(cv::Mat &src) { preprocess(src, inputTensor_.data()); }
+
+  void preprocess(cv::Mat &src, float *out) {
+    cv::resize(src, resized_, cv::Size(inW_, inH_));
+
+    // (v / 255 - mean) / std folded into v * scale + bias, RGB plane order
+    static const float mean[3] = {0.485f, 0.456f, 0.406f};
+    static const float stdv[3] = {0.229f, 0.224f, 0.225f};
+    float scale[3], bias[3];
+    for (int c = 0; c < 3; c++) {
+      scale[c] = 1.0f / (255.0f * stdv[c]);
+      bias[c] = -mean[c] / stdv[c];
+    }
+
+    size_t plane = (size_t)inH_ * inW_;
+    float *r = out;
+    float *g = r + plane;
+    float *b = g + plane;
+    for (int h = 0; h < inH_; h++) {
+      const uchar *p = resized_.ptr<uchar>(h);
+      size_t o = (size_t)h * inW_;
+      for (int w = 0; w < inW_; w++) {
+        r[o + w] = p[3 * w + 2] * scale[0] + bias[0];
+        g[o + w] = p[3 * w + 1] * scale[1] + bias[1];
+        b[o + w] = p[3 * w] * scale[2] + bias[2];
+      }
+    }
+  }
+
+  DA2Config config_;
   Ort::Session *session_;
   Ort::Env *env_;
+  Ort::IoBinding *binding_;
+  Ort::RunOptions runOptions_;
+  Ort::Value inputValue_, outputValue_;
   std::string inputName_, outputName_;
   std::vector<int64_t> inputShape_;
+  size_t outputRank_ = 3;
+  int inH_ = 518, inW_ = 518;
+  std::vector<float> inputTensor_, outputTensor_, batchInput_;
+  cv::Mat resized_, norm_, raw_;
   bool initialized_;
+  bool outputBound_;
+  double preMs_, inferMs_, postMs_;
 };
 
 #endif
@@ -0,0 +1,107 @@
+/**
+ * depthService.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Runs DA2Network on its own thread so the display never waits on the model,
+ * and batches depth requests from several streams.
+ */
+
+#ifndef DEPTHSERVICE_H
+#define DEPTHSERVICE_H
+
+#include "DA2Network.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <thread>
+#include <vector>
+
+struct DepthPolicy {
+  int inferEvery = 1;    // hand every Nth frame to the model
+  int maxStaleness = 30; // frames; an older map makes update() wait
+  float blend = 0.0f;    // weight of the previous map when a new one lands
+};
+
+// The worker always takes the newest submitted frame; frames submitted while
+// it is busy overwrite each other. Callers keep using the last finished
+// map, blended toward the new one as results arrive.
+class DepthService {
+public:
+  explicit DepthService(DA2Network &net, const DepthPolicy &policy);
+  ~DepthService();
+
+  void start();
+  void stop();
+
+  // Call once per frame. Submits the frame when due and writes the most
+  // recent depth map (at frame size, or the model's size with
+  // DA2Config::lowResOutput) to depth. False until a map exists.
+  bool update(const cv::Mat &frame, cv::Mat &depth);
+
+  // Frames between the last frame passed to update() and the one the
+  // current depth map was computed from
+  long staleness();
+  long inferences();
+
+private:
+  void loop();
+
+  DA2Network &net_;
+  DepthPolicy policy_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wake_, done_;
+  bool running_;
+
+  cv::Mat pending_; // newest frame waiting for the model
+  long pendingFrame_;
+  bool hasPending_;
+
+  cv::Mat result_; // last finished map
+  long resultFrame_;
+  long resultCount_;
+
+  cv::Mat blended_; // what update() hands out
+  long blendedCount_;
+
+  long frameId_, lastSubmit_;
+};
+
+// Collects depth requests from several threads (e.g. one per video stream)
+// and runs them through the model as one batch. A batch starts once
+// maxBatch requests are waiting or the oldest has waited waitMs.
+class DepthBatcher {
+public:
+  DepthBatcher(DA2Network &net, int maxBatch, int waitMs);
+  ~DepthBatcher();
+
+  void start();
+  void stop(); // the batch already running finishes first
+
+  // Blocks until the batch holding frame has run. Same result as
+  // DA2Network::process.
+  bool process(const cv::Mat &frame, cv::Mat &depth);
+
+  long batches();
+  long frames();
+
+private:
+  struct Request {
+    const cv::Mat *frame;
+    cv::Mat *depth;
+    bool taken; // off queue_ and in the running batch
+    bool done, ok;
+  };
+  void loop();
+
+  DA2Network &net_;
+  int maxBatch_, waitMs_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wake_, done_;
+  bool running_;
+  std::vector<Request *> queue_;
+  std::vector<cv::Mat> srcs_, dsts_; // batch scratch, reused
+  long batches_, frames_;
+};
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * dirtyTiles.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Re-runs a filter only on the tiles of a frame that changed, for fixed
+ * cameras where most of the scene is static.
+ */
+
+#ifndef DIRTYTILES_H
+#define DIRTYTILES_H
+
+#include "scaledFilter.h"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+struct DirtyTileConfig {
+  int tile = 32;         // tile side in pixels
+  int threshold = 16;    // a byte changed if it moved more than this
+  int minChanged = 8;    // a tile is dirty with more changed bytes than this
+  int refreshEvery = 60; // recompute the whole frame every n frames, 0 = off
+};
+
+// Each tile is compared with the input its cached output was made from
+// (not just the previous frame), so slow changes add up until the tile is
+// redone. The comparison covers the tile plus `halo` pixels on every side,
+// since a change just across the edge moves the tile's border outputs too.
+// Dirty tiles next to each other in a row are filtered together, with the
+// same halo around them so kernels see real neighbours; only the inside is
+// kept. fn must not depend on the pixel position (no
+// vignettes) and must be safe to call on several tiles at once.
+class DirtyTileFilter {
+public:
+  explicit DirtyTileFilter(const DirtyTileConfig &config = DirtyTileConfig());
+
+  void setConfig(const DirtyTileConfig &config);
+
+  // Forgets the cache, the next frame is filtered in full
+  void reset();
+
+  // dst = fn(src), recomputed only where src changed. halo >= the radius
+  // of fn's largest kernel chain.
+  int apply(cv::Mat &src, cv::Mat &dst, const FilterFn &fn, int halo);
+
+  // Fraction of tiles recomputed in the last frame, and over all frames
+  double lastFraction() const { return lastFraction_; }
+  double totalFraction() const {
+    return tilesTotal_ > 0 ? (double)tilesDone_ / tilesTotal_ : 0;
+  }
+  long tilesDone() const { return tilesDone_; }
+  long tilesTotal() const { return tilesTotal_; }
+
+private:
+  void findDirty(const cv::Mat &src, int halo);
+
+  DirtyTileConfig config_;
+  cv::Mat ref_, out_; // input the cached output came from, cached output
+  std::vector<int> changed_; // changed bytes per tile and its halo
+  std::vector<cv::Rect> rects_;
+  std::vector<cv::Mat> scratch_; // one per rect
+  int tilesX_, tilesY_;
+  int sinceRefresh_;
+  double lastFraction_;
+  long tilesDone_, tilesTotal_;
+};
+
+#endif
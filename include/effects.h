@@ -0,0 +1,90 @@
+/**
+ * effects.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Key-driven effect dispatch shared by the live and headless video paths.
+ */
+
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "depthService.h"
+#include "dirtyTiles.h"
+#include "faceDetect.h"
+#include "faceTracker.h"
+#include "filterGraph.h"
+#include "greyFrame.h"
+#include "scaledFilter.h"
+#include "temporal.h"
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// Keys that select an effect (see readme.txt)
+#define EFFECT_KEYS "cghpbxymlf1234adk56789"
+
+// Scratch buffers reused across frames by applyEffect
+struct EffectState {
+  GreyFrame grey; // grey, half-size and equalized copies of this frame
+  cv::Mat sobelX, sobelY, depthMap;
+  std::vector<cv::Rect> faces;
+  std::vector<int> faceIds; // tracker id of each face
+  FaceTracker faceTracker;  // modes f and 1
+  FilterGraph graph; // built for graphMode, rebuilt when the mode changes
+  char graphMode = 0;
+  ScaledBuffers scaled; // modes with a processing scale
+  FrameHistory history; // modes 5-9, sized for historyMode
+  char historyMode = 0;
+  DirtyTileFilter dirty; // cached output of dirtyMode
+  char dirtyMode = 0;
+};
+
+bool isEffectKey(char key);
+
+// Filter graph chain shown by the 'k' key, e.g. "fog>cartoon".
+// Returns false if the spec names an unknown effect.
+bool setEffectChain(const std::string &spec);
+bool ensureDepthNetwork();
+
+// Session settings and model used when the depth network is first loaded
+void setDepthConfig(const DA2Config &config);
+
+// Detector settings for modes f and 1, set before the first frame
+void setFaceDetectorConfig(const FaceDetectorConfig &config);
+
+// Path of the model named by config (searched in ../data and data), or ""
+std::string findDepthModel(const DA2Config &config);
+
+// Frame counts and thresholds of the temporal modes 5-9
+void setTemporalConfig(const TemporalConfig &config);
+
+// Fog colour and density of mode 4 and fog chains
+void setFogStyle(const FogStyle &style);
+
+// Modes b, m, l and 2 recompute only the tiles that changed since
+// their cached output (for fixed cameras). The fraction of tiles redone
+// is printed by shutdownEffects().
+void setDirtyTiles(const DirtyTileConfig &config);
+
+// Run depth inference on a background thread (modes d, 4 and fog chains)
+void setAsyncDepth(const DepthPolicy &policy);
+
+// Depth requests from concurrent callers (e.g. several streams) are run
+// through the model together, up to maxBatch frames, waiting at most
+// waitMs for a batch to fill
+void setDepthBatching(int maxBatch, int waitMs);
+
+// Runs mode at 1/scale resolution (1, 2 or 4) and upsamples the result
+// guided by the full frame. Returns false for other scales or keys.
+bool setProcessingScale(char mode, int scale);
+int processingScale(char mode);
+
+// Stops background work before exit
+void shutdownEffects();
+// Modes g and h write a single-channel dst; other modes write BGR
+int applyEffect(char mode, cv::Mat &frame, cv::Mat &dst, EffectState &state);
+
+// frame if it is BGR, else frame expanded into scratch. For encoders and
+// anything else that needs three channels; display takes either.
+const cv::Mat &asBgr(const cv::Mat &frame, cv::Mat &scratch);
+
+#endif
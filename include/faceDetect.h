@@ -8,12 +8,76 @@
 #ifndef FACEDETECT_H
 #define FACEDETECT_H
 
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
 // put the path to the haar cascade file here
 #define FACE_CASCADE_FILE "../data/haarcascade_frontalface_alt2.xml"
 
+// detectMultiScale settings; sizes are in full-resolution pixels
+struct FaceDetectorConfig {
+  std::string cascadeFile = FACE_CASCADE_FILE;
+  double scaleFactor = 1.1;
+  int minNeighbors = 3;
+  cv::Size minSize; // empty = no limit
+  cv::Size maxSize; // empty = no limit
+  int downscale = 2; // detect on an image this many times smaller
+};
+
+// Haar face detector that can be shared between threads. Each concurrent
+// caller gets its own classifier and scratch image from a small pool, so
+// detect() may run on several frames at once.
+class FaceDetector {
+public:
+  explicit FaceDetector(
+      const FaceDetectorConfig &config = FaceDetectorConfig());
+
+  // Loads the cascade (done by the first detect() too). False on failure,
+  // with the reason in error().
+  bool load();
+
+  // Faces in a greyscale image, in its coordinates. False if the cascade
+  // could not be loaded.
+  bool detect(const cv::Mat &grey, std::vector<cv::Rect> &faces);
+
+  // Same, for a grey image already shrunk by config().downscale and
+  // equalized (e.g. one shared by several users of a frame). Faces are
+  // in full-size coordinates.
+  bool detectPrepared(const cv::Mat &small, std::vector<cv::Rect> &faces);
+
+  // detect() on every image, run in parallel
+  bool detectBatch(const std::vector<cv::Mat> &greys,
+                   std::vector<std::vector<cv::Rect>> &faces);
+
+  const FaceDetectorConfig &config() const { return config_; }
+  std::string error();
+
+private:
+  struct Worker {
+    cv::CascadeClassifier cascade;
+    cv::Mat small;
+  };
+  std::unique_ptr<Worker> acquire();
+  void runCascade(Worker &worker, const cv::Mat &small,
+                  std::vector<cv::Rect> &faces);
+  void release(std::unique_ptr<Worker> worker);
+
+  FaceDetectorConfig config_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Worker>> idle_;
+  bool failed_;
+  std::string error_;
+};
+
 // prototypes
 int detectFaces(cv::Mat &grey, std::vector<cv::Rect> &faces);
 int drawBoxes(cv::Mat &frame, std::vector<cv::Rect> &faces, int minWidth = 50,
               float scale = 1.0);
+int drawBoxes(cv::Mat &frame, std::vector<cv::Rect> &faces,
+              const std::vector<int> &ids, int minWidth = 50,
+              float scale = 1.0);
 
 #endif
@@ -0,0 +1,70 @@
+/**
+ * faceTracker.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Keeps faces between Haar detections by template matching near the last
+ * box, so the full detector only runs every few frames.
+ */
+
+#ifndef FACETRACKER_H
+#define FACETRACKER_H
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Same signature as detectFaces
+typedef std::function<int(cv::Mat &grey, std::vector<cv::Rect> &faces)>
+    FaceDetectFn;
+
+struct FaceTrackerConfig {
+  int detectEvery = 10;     // frames between full-frame detections
+  float minScore = 0.6f;    // template match score below this = lost
+  float searchMargin = 0.5f; // search window around the box, in box sizes
+  int maxMisses = 3;        // failed checks before a face is dropped
+  float smoothing = 0.3f;   // weight of the old box when a detection lands
+  int scale = 2;            // matching runs at 1/scale resolution
+};
+
+struct TrackedFace {
+  int id;         // stays the same while the face is tracked
+  cv::Rect box;   // full-resolution frame coordinates
+  float score;    // last template match score (1 after a detection)
+  int misses;
+  cv::Mat templ;  // grey patch at 1/scale, refreshed on every detection
+};
+
+class FaceTracker {
+public:
+  explicit FaceTracker(const FaceTrackerConfig &config = FaceTrackerConfig());
+
+  // Tracks the faces into grey (CV_8UC1), running detect over the whole
+  // frame when due and inside a window around a face that was lost
+  const std::vector<TrackedFace> &update(cv::Mat &grey,
+                                         const FaceDetectFn &detect);
+
+  // Current boxes and their ids, in the same order
+  void boxes(std::vector<cv::Rect> &faces, std::vector<int> &ids) const;
+  void reset();
+
+  long frames() const { return frames_; }
+  long fullDetections() const { return fullDetections_; }
+  long roiDetections() const { return roiDetections_; }
+
+private:
+  bool track(const cv::Mat &grey, TrackedFace &face);
+  bool redetect(cv::Mat &grey, TrackedFace &face, const FaceDetectFn &detect);
+  void detectAll(cv::Mat &grey, const FaceDetectFn &detect);
+  void setBox(const cv::Mat &grey, TrackedFace &face, const cv::Rect &box,
+              bool smooth);
+
+  FaceTrackerConfig config_;
+  std::vector<TrackedFace> faces_;
+  std::vector<cv::Rect> found_;
+  std::vector<char> missed_; // faces already counted a miss this frame
+  cv::Mat search_, score_;
+  int nextId_;
+  int sinceDetect_;
+  long frames_, fullDetections_, roiDetections_;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * filterGraph.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Effects as a graph of filters.h nodes with per-frame buffer reuse.
+ *
+ * A chain spec such as "fog>cartoon" or "blur>neon" names effects applied
+ * left to right. Each effect expands into nodes; a node with the same
+ * operation and inputs as an existing one is reused, so e.g. the edge map
+ * shared by "neon" and "cartoon" on the same input is computed once.
+ * Effect names: grey sepia blur smooth[:sigma] quantize[:levels] edges neon
+ * cartoon[:levels] painterly depth fog
+ */
+
+#ifndef FILTERGRAPH_H
+#define FILTERGRAPH_H
+
+#include "filters.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Buffers that live for one frame. reset() at the start of a frame makes
+// every buffer available again; requests come in the same order each frame,
+// so after the first frame acquire() never touches the heap.
+class FrameArena {
+public:
+  cv::Mat &acquire(cv::Size size, int type);
+  void reset();
+  size_t allocations() const { return allocations_; }
+  size_t buffers() const { return slots_.size(); }
+
+private:
+  struct Slot {
+    cv::Mat mat;
+    bool used = false;
+  };
+  std::deque<Slot> slots_; // deque keeps references stable on growth
+  size_t allocations_ = 0;
+};
+
+class FilterGraph {
+public:
+  enum Op {
+    SOURCE,
+    GREY,
+    SEPIA,
+    BLUR,
+    QUANTIZE,
+    EDGES,
+    MAGNITUDE,
+    NEON,
+    CARTOON,
+    SMOOTH,
+    PAINTERLY,
+    DEPTH,
+    DEPTH_BGR,
+    FOG
+  };
+
+  // Computes a CV_8UC1 depth map for src, false if no model is available
+  typedef std::function<bool(cv::Mat &src, cv::Mat &depth)> DepthFn;
+
+  FilterGraph();
+
+  void clear();
+  void setDepthFn(DepthFn fn) { depthFn_ = fn; }
+  void setFogStyle(const FogStyle &style) { fog_ = style; }
+
+  // Node 0 is the input frame
+  int source() const { return 0; }
+  int addNode(Op op, int in0, int in1 = -1, int param = 0);
+
+  // Expands one named effect applied to input, -1 if the name is unknown
+  int addEffect(const std::string &name, int input);
+
+  // Adds "a>b>c" starting at input and makes it the output, -1 on error
+  int addChain(const std::string &spec, int input = 0);
+
+  // Evaluates every node for src; the output node is written into dst
+  int run(cv::Mat &src, cv::Mat &dst);
+
+  // Result of any node from the last run()
+  cv::Mat &output(int node) { return *nodes_[node].out; }
+
+  size_t nodeCount() const { return nodes_.size(); }
+  const FrameArena &arena() const { return arena_; }
+
+private:
+  struct Node {
+    Op op;
+    int in0, in1, param;
+    cv::Mat *out;
+    cv::Mat own; // DEPTH: the map may be smaller than the frame
+  };
+
+  void eval(Node &n, cv::Mat &out);
+
+  std::vector<Node> nodes_;
+  std::map<std::tuple<int, int, int, int>, int> index_;
+  FrameArena arena_;
+  DepthFn depthFn_;
+  FogStyle fog_;
+  cv::Mat source_;
+  int output_;
+};
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * filterKernels.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Per-row inner loops of the filters, built once per instruction set
+ * (baseline, AVX2, AVX-512) and picked at runtime for this CPU.
+ */
+
+#ifndef FILTERKERNELS_H
+#define FILTERKERNELS_H
+
+#include <cstdint>
+
+struct FilterKernels {
+  const char *name;
+
+  // BGR row to one byte per pixel, (max + min) / 2
+  void (*greyRow)(const uint8_t *src, uint8_t *dst, int cols);
+
+  // Fixed-point sepia of a BGR row: col holds the 12-bit vignette column
+  // term, rowTerm the row term subtracted from it
+  void (*sepiaRow)(const uint8_t *src, uint8_t *dst, int cols,
+                   const int *col, int rowTerm);
+
+  // Sobel magnitude per byte of a BGR row from the rows above and below,
+  // for bytes 3 .. (cols - 1) * 3 - 1 (the border pixels are left alone)
+  void (*sobelMagRow)(const uint8_t *up, const uint8_t *mid,
+                      const uint8_t *dn, uint8_t *dst, int cols);
+
+  // Channel mean of the same magnitudes, one byte per pixel, for pixels
+  // 1 .. cols - 2
+  void (*sobelEdgesRow)(const uint8_t *up, const uint8_t *mid,
+                        const uint8_t *dn, uint8_t *dst, int cols);
+
+  // Fog blend of a BGR row in 8.8 fixed point: (src * keep + add) >> 8,
+  // keep per pixel and add per byte, both already looked up from depth
+  void (*fogRow)(const uint8_t *src, uint8_t *dst, int cols,
+                 const uint16_t *keep, const uint16_t *add);
+
+  // One step of a recursive filter across a whole row of n floats:
+  // cur += weight * (prev - cur)
+  void (*recursiveRow)(float *cur, const float *prev, const float *weight,
+                       int n);
+};
+
+// Kernels for this CPU: the widest instruction set that was built in and
+// that the CPU supports
+const FilterKernels &filterKernels();
+
+// "baseline", "avx2" or "avx512"; false if not built or not supported
+bool setFilterKernels(const char *name);
+
+#endif
@@ -11,16 +11,51 @@
 #include <vector>
 
 int greyscale(cv::Mat &src, cv::Mat &dst);
+int greyscalePlane(cv::Mat &src, cv::Mat &dst); // CV_8UC1 output
 int sepia(cv::Mat &src, cv::Mat &dst);
 int blur5x5_1(cv::Mat &src, cv::Mat &dst);
 int blur5x5_2(cv::Mat &src, cv::Mat &dst);
+int blur5x5_3(cv::Mat &src, cv::Mat &dst);
 int sobelX3x3(cv::Mat &src, cv::Mat &dst);
 int sobelY3x3(cv::Mat &src, cv::Mat &dst);
 int magnitude(cv::Mat &sx, cv::Mat &sy, cv::Mat &dst);
+int sobelMagnitude3x3(cv::Mat &src, cv::Mat &dst);
+int sobelEdges3x3(cv::Mat &src, cv::Mat &dst);
+int quantize(cv::Mat &src, cv::Mat &dst, int levels);
 int blurQuantize(cv::Mat &src, cv::Mat &dst, int levels);
 int spotlight(cv::Mat &src, cv::Mat &dst, std::vector<cv::Rect> &faces);
 int neonEdges(cv::Mat &src, cv::Mat &dst);
 int cartoon(cv::Mat &src, cv::Mat &dst, int levels);
-int digitalFog(cv::Mat &src, cv::Mat &depthMap, cv::Mat &dst);
+int painterly(cv::Mat &src, cv::Mat &dst);
+
+// Edge-preserving smoothing (recursive domain transform, see
+// domainTransform.cpp): sigmaS is the spatial reach in pixels, sigmaR the
+// colour difference (0-255 per channel) that still gets smoothed across.
+// Cost per pixel does not depend on either.
+int domainTransform(cv::Mat &src, cv::Mat &dst, float sigmaS = 20.0f,
+                    float sigmaR = 40.0f, int iterations = 3);
+
+// Second halves of neonEdges, cartoon and painterly, for callers that
+// already have the sobelEdges3x3 strength and the smoothed or quantized
+// image
+int neonCompose(cv::Mat &src, cv::Mat &edges, cv::Mat &dst);
+int cartoonCompose(cv::Mat &quantized, cv::Mat &edges, cv::Mat &dst);
+int painterlyCompose(cv::Mat &smooth, cv::Mat &edges, cv::Mat &dst);
+
+// Fog colour (BGR) and how fast it thickens with depth:
+// fog = 1 - exp(-density * depth / 255)
+struct FogStyle {
+  cv::Vec3b colour = cv::Vec3b(255, 255, 255);
+  float density = 3.0f;
+};
+
+// depthMap is CV_8UC1 at src size or smaller (sampled bilinearly)
+int digitalFog(cv::Mat &src, cv::Mat &depthMap, cv::Mat &dst,
+               const FogStyle &style = FogStyle());
+int depthToBgr(cv::Mat &depth, cv::Size size, cv::Mat &dst);
+
+// SIMD path used by blur5x5_3: "avx2", "sse4.1", "neon" or "scalar"
+const char *blurSimdPath();
+bool setBlurSimdPath(const char *name);
 
 #endif
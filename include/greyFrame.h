@@ -0,0 +1,34 @@
+/**
+ * greyFrame.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Grey versions of the current frame, each made once and shared by every
+ * effect and detector that needs it.
+ */
+
+#ifndef GREYFRAME_H
+#define GREYFRAME_H
+
+#include <opencv2/opencv.hpp>
+
+class GreyFrame {
+public:
+  // Starts a new frame (keeps a header, no copy). Nothing is converted
+  // until one of the getters asks for it.
+  void reset(const cv::Mat &frame);
+
+  // The frame as CV_8UC1 (frame itself if it already is single-channel)
+  const cv::Mat &grey();
+
+  // grey() at 1/d size, resized the way FaceDetector does (INTER_LINEAR)
+  const cv::Mat &small(int d);
+
+  // equalizeHist of small(d), the face detector's input
+  const cv::Mat &equalized(int d);
+
+private:
+  cv::Mat frame_, grey_, small_, equalized_;
+  bool haveGrey_ = false;
+  int smallD_ = 0, equalizedD_ = 0; // 0 = not made for this frame
+};
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * parallel.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Row-band executor shared by the filters.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+// Number of threads the filters may use, 0 = one per core
+void setFilterThreads(int n);
+int getFilterThreads();
+
+// Splits [0, rows) into contiguous bands and runs body(r0, r1) on each band
+// in parallel. Bands never overlap, so each output row has a single writer;
+// a filter that reads neighbouring rows recomputes that halo itself.
+void parallelRows(int rows, const std::function<void(int, int)> &body);
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * pipeline.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Threaded capture -> filter -> display pipeline.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "effects.h"
+#include "rawFrames.h"
+#include "recorder.h"
+#include "ringBuffer.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PipelineConfig {
+  int workers = 2;    // filter threads
+  int queueDepth = 4; // slots per ring
+  QueuePolicy policy = QueuePolicy::Block;
+};
+
+struct FrameSlot {
+  cv::Mat frame;
+  long seq = 0;
+  char mode = 'c';
+};
+
+// Frame n goes to worker n % workers through that worker's input ring and
+// comes back through its output ring, so next() can restore capture order.
+class FramePipeline {
+public:
+  explicit FramePipeline(const PipelineConfig &cfg);
+  ~FramePipeline();
+
+  // Starts the capture thread and filter workers reading from cap
+  bool start(cv::VideoCapture &cap, char mode);
+  // Same from a .vraw replay: slots get views into the file, no copies
+  bool start(RawReplay &replay, cv::Size size, char mode);
+
+  // Before start: every captured frame also goes to rec, stamped n / fps
+  // for frame n, or with the capture time when fps is 0
+  void recordCapture(Recorder *rec, double fps) {
+    captureRec_ = rec;
+    captureFps_ = fps;
+  }
+  void stop();
+
+  // Display stage: waits for the next frame in capture order.
+  // Returns false once the input has ended and every frame was delivered.
+  bool next(cv::Mat &displayFrame);
+
+  void setMode(char mode) { mode_.store(mode); }
+
+  long dropped() const { return dropped_.load(); }
+  std::string queueDepths() const;
+
+private:
+  typedef SpscRing<FrameSlot> Ring;
+  typedef std::function<bool(cv::Mat &)> Grab; // false at the end
+
+  bool startWith(Grab grab, cv::Size size, bool allocInput, char mode);
+  void captureLoop(Grab grab);
+  void workerLoop(int id);
+  bool running() const { return running_.load(std::memory_order_relaxed); }
+
+  PipelineConfig cfg_;
+  std::vector<std::unique_ptr<Ring>> in_, out_;
+  std::vector<EffectState> states_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_;
+  std::atomic<bool> captureDone_;
+  std::atomic<int> workersDone_;
+  std::atomic<char> mode_;
+  std::atomic<long> dropped_;
+  long nextSeq_;
+  Recorder *captureRec_;
+  double captureFps_;
+};
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * rawFrames.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Uncompressed frame files (.vraw) for repeatable replay and benchmarks.
+ *
+ * Layout: a 64-byte header padded to 4096 bytes, then fixed-size frame
+ * records, so frame n is at dataOffset + n * recordBytes. Each record is
+ * 64 bytes (capture time in microseconds, sequence number) followed by the
+ * pixel rows, each padded to a multiple of 64 bytes. Rows are written in
+ * the machine's byte order and read by mapping the file, so replay does no
+ * decoding and no copying.
+ */
+
+#ifndef RAWFRAMES_H
+#define RAWFRAMES_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// true for paths ending in .vraw
+bool isRawFramePath(const std::string &path);
+
+struct RawFileHeader {
+  char magic[8];        // "VFXRAW\0\0"
+  uint32_t version;     // 1
+  uint32_t type;        // CV_8UC3 or CV_8UC1
+  uint32_t width, height;
+  uint32_t stride;      // bytes per row, multiple of 64
+  uint32_t dataOffset;  // first record
+  uint64_t recordBytes; // 64 + stride * height
+  uint64_t frameCount;  // written on close; 0 = count from the file size
+  double fps;
+  uint8_t reserved[8];
+};
+static_assert(sizeof(RawFileHeader) == 64, "header layout");
+
+// Appends frames to a .vraw file. Every frame must have the size and type
+// of the first one.
+class RawFrameWriter {
+public:
+  RawFrameWriter();
+  ~RawFrameWriter();
+
+  bool open(const std::string &path, cv::Size size, int type, double fps);
+  bool write(const cv::Mat &frame, int64_t timestampUs);
+  void close(); // writes the frame count into the header
+
+  bool isOpened() const { return file_ != nullptr; }
+  int type() const { return (int)header_.type; }
+  long frames() const { return (long)header_.frameCount; }
+
+private:
+  FILE *file_;
+  RawFileHeader header_;
+  std::vector<uchar> padding_;
+};
+
+// Maps a .vraw file. The pages are mapped private and writable: frames are
+// views into the mapping, and a filter that writes into its source gets
+// its own copy of those pages instead of changing the file.
+class RawFrameReader {
+public:
+  RawFrameReader();
+  ~RawFrameReader();
+
+  bool open(const std::string &path);
+  void close();
+
+  bool isOpened() const { return base_ != nullptr; }
+  long frames() const { return frames_; }
+  cv::Size size() const { return cv::Size(header_.width, header_.height); }
+  int type() const { return (int)header_.type; }
+  double fps() const { return header_.fps; }
+
+  // Zero-copy view of frame n, valid until close()
+  cv::Mat frame(long n) const;
+  int64_t timestampUs(long n) const;
+
+private:
+  uchar *record(long n) const {
+    return base_ + header_.dataOffset + n * header_.recordBytes;
+  }
+
+  uchar *base_;
+  size_t length_;
+  long frames_;
+  RawFileHeader header_;
+};
+
+// Hands out the frames of a file in order, paced by their timestamps at
+// speed times real time (0 = as fast as they are asked for). One thread
+// calls next().
+class RawReplay {
+public:
+  explicit RawReplay(const RawFrameReader &file, double speed = 0,
+                     bool loop = false);
+
+  // Next frame as a view into the file (grey files: a BGR copy in frame's
+  // buffer); false at the end
+  bool next(cv::Mat &frame);
+
+  long position() const { return next_; }
+
+private:
+  const RawFrameReader &file_;
+  double speed_;
+  bool loop_;
+  long next_;
+  int64_t offsetUs_; // added to timestamps after a loop
+  std::chrono::steady_clock::time_point start_;
+};
+
+#endif
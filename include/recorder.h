@@ -0,0 +1,98 @@
+/**
+ * recorder.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Video recording and snapshots on a writer thread, off the display loop.
+ * A path ending in .vraw records uncompressed frames (see rawFrames.h).
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "rawFrames.h"
+#include "ringBuffer.h"
+#include "stageTimer.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+
+struct RecorderConfig {
+  std::string path;              // video file, "" = ../data/recording_<time>
+  std::string container = "avi"; // extension used when path is ""
+  std::string fourcc = "MJPG";
+  double fps = 0; // 0 = 30
+  int quality = 90;                   // 0-100, for codecs that take it
+  std::string snapshotFormat = "png"; // png or jpg
+  int queueDepth = 8;                 // frames waiting for the writer
+  bool dropWhenFull = true; // false: addFrame waits for the writer
+};
+
+// The display thread copies a frame into a free slot of a ring and goes
+// on; one writer thread encodes. A full queue drops the frame (counted)
+// instead of making the display wait, so recording never costs frames on
+// screen (unless dropWhenFull is off, for copies that must keep every
+// frame). Only one thread may call addFrame() and snapshot().
+class Recorder {
+public:
+  explicit Recorder(const RecorderConfig &cfg);
+  ~Recorder();
+
+  bool start();
+  void stop(); // writes what is queued, then closes the file
+
+  // Continuous recording; each start opens a new file
+  void setRecording(bool on);
+  bool recording() const { return recording_.load(); }
+
+  // Queues a frame for the video if recording. Returns false if dropped.
+  // .vraw files store timestampUs, or the time since the recording started
+  // when it is negative.
+  bool addFrame(const cv::Mat &frame, int64_t timestampUs = -1);
+
+  // Queues an image save and returns its file name, or "" if dropped
+  std::string snapshot(const cv::Mat &frame);
+
+  // Written, dropped and snapshot counts, queue-to-disk latency
+  std::string stats() const;
+
+private:
+  struct Slot {
+    cv::Mat frame;
+    int segment = 0;       // recording the frame belongs to
+    std::string videoPath; // file of that recording
+    std::string snapshot;  // image path, "" = video frame
+    int64_t timestampUs = -1;
+    std::chrono::steady_clock::time_point queued;
+  };
+
+  bool push(const cv::Mat &frame, const std::string &snapshot,
+            int64_t timestampUs);
+  void writerLoop();
+  bool openVideo(Slot &slot);
+  void writeVideo(Slot &slot);
+  void writeSnapshot(Slot &slot);
+  std::string nextPath(const char *prefix, const std::string &ext);
+
+  RecorderConfig cfg_;
+  SpscRing<Slot> ring_;
+  std::thread thread_;
+  std::atomic<bool> running_, recording_;
+
+  // producer thread only
+  int segment_, counter_;
+  std::string segmentPath_;
+
+  // writer thread only
+  cv::VideoWriter writer_;
+  RawFrameWriter raw_;
+  std::chrono::steady_clock::time_point rawStart_;
+  cv::Mat bgr_;
+  int openSegment_;
+
+  std::atomic<long> written_, dropped_, snapshots_, failed_;
+  LatencyHistogram latency_; // queued -> on disk, us
+};
+
+#endif
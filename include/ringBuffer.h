@@ -0,0 +1,76 @@
+/**
+ * ringBuffer.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Lock-free single-producer/single-consumer ring of preallocated slots.
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// What a stage does when the queue in front of it is full
+enum class QueuePolicy {
+  Block,     // producer waits for space, every frame is kept
+  DropOldest // consumer skips stale entries, producer never waits
+};
+
+// Slots are written and read in place: the producer fills writeSlot() and
+// calls commitWrite(), the consumer uses readSlot() and calls commitRead().
+// Exactly one thread may produce and one thread may consume.
+template <typename T> class SpscRing {
+public:
+  explicit SpscRing(size_t capacity)
+      : slots_(capacity > 0 ? capacity : 1), head_(0), tail_(0) {}
+
+  size_t capacity() const { return slots_.size(); }
+
+  // Number of committed entries not yet consumed
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Producer side: next free slot, or nullptr if the ring is full
+  T *writeSlot() {
+    size_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) >= slots_.size())
+      return nullptr;
+    return &slots_[h % slots_.size()];
+  }
+
+  void commitWrite() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  // Consumer side: oldest committed slot, or nullptr if the ring is empty
+  T *readSlot() {
+    size_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire))
+      return nullptr;
+    return &slots_[t % slots_.size()];
+  }
+
+  void commitRead() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  // Only call before the producer and consumer threads start
+  template <typename F> void forEachSlot(F fn) {
+    for (auto &s : slots_)
+      fn(s);
+  }
+
+private:
+  std::vector<T> slots_;
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * scaledFilter.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Runs a filter on a downscaled frame and brings the result back to full
+ * size with a joint bilateral upsampler guided by the full-size frame.
+ */
+
+#ifndef SCALEDFILTER_H
+#define SCALEDFILTER_H
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+// Any filter from filters.h that maps src to dst; bind extra arguments
+// with a lambda, e.g. [](cv::Mat &s, cv::Mat &d) { return cartoon(s, d, 10); }
+typedef std::function<int(cv::Mat &, cv::Mat &)> FilterFn;
+
+// Scratch reused across frames by processScaled
+struct ScaledBuffers {
+  cv::Mat small, smallDst, smallBgr;
+};
+
+// Upsamples lowDst (the filter output for lowGuide) to guide's size. Each
+// output pixel mixes its 2x2 low-res neighbours with bilinear weights times
+// a range weight on how close each neighbour's lowGuide colour is to the
+// guide pixel, so filter edges follow the edges of the full-size frame.
+// sigma is in grey levels. lowGuide and lowDst are CV_8UC3 of one size,
+// guide is CV_8UC3; dst must not be guide.
+int jointBilateralUpsample(cv::Mat &lowGuide, cv::Mat &lowDst,
+                           cv::Mat &guide, cv::Mat &dst, float sigma = 16);
+
+// Runs fn at 1/scale size (INTER_AREA) and upsamples the result to src's
+// size. scale <= 1 calls fn(src, dst) directly. fn may return a CV_8UC1 or
+// CV_8UC3 image; dst is CV_8UC3 and must not be src.
+int processScaled(cv::Mat &src, cv::Mat &dst, int scale, const FilterFn &fn,
+                  ScaledBuffers &buf);
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * stageTimer.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Per-stage latency histograms fed by scoped timers on the hot path.
+ *
+ * Recording is two steady_clock reads and two relaxed atomic adds, with no
+ * locks or allocation, so the timers stay on in normal runs. Readers take
+ * windows (differences between snapshots) for the HUD and the metrics dump.
+ */
+
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+enum class Stage {
+  Capture,
+  Filter, // whole applyEffect call
+  Faces,
+  DepthPre,
+  DepthInfer,
+  DepthPost,
+  Display,
+  Encode,
+  Count
+};
+
+const char *stageName(Stage stage);
+
+// Log-linear histogram of microseconds: exact below 8 us, then 4 buckets
+// per power of two (at most 25% wide), up to about an hour
+class LatencyHistogram {
+public:
+  static const int BUCKETS = 128;
+
+  LatencyHistogram() {
+    for (auto &c : counts_)
+      c.store(0, std::memory_order_relaxed);
+  }
+
+  void record(uint64_t us) {
+    counts_[bucket(us)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+  }
+
+  // Plain copy of the counters; may straddle a concurrent record()
+  void snapshot(std::vector<uint64_t> &counts, uint64_t &sum) const {
+    counts.resize(BUCKETS);
+    for (int i = 0; i < BUCKETS; i++)
+      counts[i] = counts_[i].load(std::memory_order_relaxed);
+    sum = sum_.load(std::memory_order_relaxed);
+  }
+
+  static int bucket(uint64_t us) {
+    if (us < 8)
+      return (int)us;
+    int e = 63 - __builtin_clzll(us); // >= 3
+    int b = 8 + (e - 3) * 4 + (int)((us >> (e - 2)) & 3);
+    return b < BUCKETS ? b : BUCKETS - 1;
+  }
+
+  // Middle of a bucket, in microseconds
+  static double bucketValue(int b) {
+    if (b < 8)
+      return b;
+    int e = (b - 8) / 4 + 3, sub = (b - 8) % 4;
+    double width = (double)(1ull << (e - 2));
+    return (4 + sub) * width + width / 2;
+  }
+
+  // Middle of the bucket holding fraction q (0-1) of all samples, in
+  // microseconds; 0 with no samples
+  double percentile(double q) const {
+    uint64_t n = 0;
+    for (const auto &c : counts_)
+      n += c.load(std::memory_order_relaxed);
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * n));
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS && n > 0; b++) {
+      seen += counts_[b].load(std::memory_order_relaxed);
+      if (seen >= rank)
+        return bucketValue(b);
+    }
+    return 0;
+  }
+
+private:
+  std::atomic<uint64_t> counts_[BUCKETS];
+  std::atomic<uint64_t> sum_{0};
+};
+
+class StageMetrics {
+public:
+  static StageMetrics &get() {
+    static StageMetrics metrics;
+    return metrics;
+  }
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void setEnabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+
+  void record(Stage stage, uint64_t us) {
+    if (enabled())
+      hist_[(int)stage].record(us);
+  }
+
+  const LatencyHistogram &histogram(Stage stage) const {
+    return hist_[(int)stage];
+  }
+
+private:
+  StageMetrics() : enabled_(true) {}
+  LatencyHistogram hist_[(int)Stage::Count];
+  std::atomic<bool> enabled_;
+};
+
+// Times its own lifetime into one stage
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Stage stage)
+      : stage_(stage), on_(StageMetrics::get().enabled()) {
+    if (on_)
+      start_ = std::chrono::steady_clock::now();
+  }
+  ~ScopedTimer() {
+    if (on_) {
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start_)
+                    .count();
+      StageMetrics::get().record(stage_, (uint64_t)us);
+    }
+  }
+
+private:
+  Stage stage_;
+  bool on_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// For stages timed elsewhere (e.g. DA2Network's own timings)
+inline void recordStageMs(Stage stage, double ms) {
+  StageMetrics::get().record(stage, (uint64_t)(ms * 1000.0));
+}
+
+struct StageStats {
+  Stage stage;
+  uint64_t count;
+  double perSec, p50Ms, p99Ms, meanMs, maxMs;
+};
+
+// Stats over the interval since the previous update()
+class MetricsWindow {
+public:
+  MetricsWindow();
+  const std::vector<StageStats> &update();
+  const std::vector<StageStats> &stats() const { return stats_; }
+  const StageStats &stats(Stage stage) const { return stats_[(int)stage]; }
+
+private:
+  std::vector<std::vector<uint64_t>> last_;
+  std::vector<uint64_t> lastSum_;
+  std::vector<uint64_t> counts_;
+  std::vector<StageStats> stats_;
+  std::chrono::steady_clock::time_point lastTime_;
+};
+
+// Appends a window of stats to a .csv file (one row per stage) or a .json
+// file (one JSON object per line) every `seconds`
+class MetricsDumper {
+public:
+  MetricsDumper(const std::string &path, double seconds);
+  bool isOpen() const { return out_.is_open(); }
+  void maybeDump();
+  void dump();
+
+private:
+  std::ofstream out_;
+  bool json_;
+  double seconds_;
+  MetricsWindow window_;
+  std::chrono::steady_clock::time_point start_, last_;
+};
+
+// Draws fps and p50/p99 of every active stage in the top left of frame
+void drawMetricsHud(cv::Mat &frame, const MetricsWindow &window);
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * streamServer.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Runs filters on several video sources in one process, sharing the worker
+ * threads, the depth network and the face detector between them.
+ */
+
+#ifndef STREAMSERVER_H
+#define STREAMSERVER_H
+
+#include "effects.h"
+#include "pipeline.h"
+#include "ringBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct StreamConfig {
+  std::string input;  // video file, image sequence or .vraw
+  std::string output; // filtered video, empty = discard
+  char mode = 'c';
+  double fps = 0;    // target rate, 0 = as fast as the input decodes
+  bool loop = false; // start the input again when it ends
+};
+
+// Each stream has a reader thread that paces its input to the target fps.
+// Workers take frames round-robin across streams, one frame per turn, so a
+// slow or fast source cannot starve the others; a stream is only ever on
+// one worker at a time, so its frames stay in order.
+class StreamServer {
+public:
+  explicit StreamServer(int workers, int queueDepth = 4);
+  ~StreamServer();
+
+  // Opens the input; returns the stream index, or -1. Call before start().
+  int addStream(const StreamConfig &cfg);
+
+  bool start();
+  void stop();
+
+  // True once every stream has ended and its last frame was processed
+  bool finished();
+
+  // One line per stream: fps since the last call, target, drops, queue
+  std::string stats();
+
+private:
+  struct Stream {
+    StreamConfig cfg;
+    cv::VideoCapture cap;
+    RawFrameReader raw; // .vraw inputs, read through replay instead of cap
+    std::unique_ptr<RawReplay> replay;
+    cv::VideoWriter writer;
+    std::unique_ptr<SpscRing<FrameSlot>> ring;
+    EffectState state;
+    cv::Mat out, bgr; // bgr: out expanded for the writer (modes g, h)
+    double inputFps = 0; // read once, cap belongs to the reader thread
+    bool busy = false; // claimed by a worker, guarded by mutex_
+    std::atomic<bool> ended{false};
+    std::atomic<long> frames{0}, dropped{0};
+    long reportFrames = 0;
+    std::chrono::steady_clock::time_point reportTime;
+  };
+
+  void readerLoop(Stream *s);
+  void workerLoop();
+  Stream *claimStream(); // call with mutex_ held
+  bool allDone();        // call with mutex_ held
+  void writeOutput(Stream *s);
+
+  int workers_, queueDepth_;
+  std::vector<std::unique_ptr<Stream>> streams_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::atomic<bool> running_;
+  size_t cursor_;
+};
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * temporal.h
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Effects over time: echo trails, temporal average and median, motion
+ * highlight and slit-scan, all reading a ring of recent frames.
+ */
+
+#ifndef TEMPORAL_H
+#define TEMPORAL_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+struct TemporalConfig {
+  int averageFrames = 8;    // mode 6, and the background of mode 7
+  int medianFrames = 5;     // mode 9, odd, at most 9
+  int echoGap = 4;          // mode 5: frames between echoes
+  int echoes = 3;           // mode 5: copies behind the current frame
+  int motionThreshold = 20; // mode 7: mean channel change that counts
+  int slitFrames = 30;      // mode 8: delay of the bottom row
+};
+
+// Preallocated ring of the last `capacity` 8-bit frames. With sums on it
+// also keeps the per-pixel sum of the frames it holds (CV_16U, so up to
+// 256 frames), updated with one add and one subtract per push; averages
+// then cost the same for any number of frames.
+class FrameHistory {
+public:
+  explicit FrameHistory(int capacity = 8, bool sums = false);
+
+  // Empties the ring; memory is reallocated on the next push
+  void configure(int capacity, bool sums);
+  void clear();
+
+  // Copies frame into the oldest slot. A frame of another size or type
+  // clears the history first.
+  void push(const cv::Mat &frame);
+
+  int size() const { return count_; }
+  int capacity() const { return (int)slots_.size(); }
+  bool hasSums() const { return sums_; }
+
+  // k frames back, 0 = newest; k is clamped to the oldest frame held
+  const cv::Mat &at(int k) const;
+
+  // Per-pixel sum of all frames held, same channels as the frames
+  const cv::Mat &sum() const { return sum_; }
+
+private:
+  std::vector<cv::Mat> slots_;
+  cv::Mat sum_;
+  bool sums_;
+  int head_;  // slot of the newest frame
+  int count_; // frames held
+};
+
+// Newest frame mixed with copies gap, 2*gap... frames back, each half as
+// strong as the one before
+int echoTrails(FrameHistory &history, cv::Mat &dst, int gap, int echoes);
+
+// Mean of the frames in history (needs sums); denoises a still scene
+int temporalAverage(FrameHistory &history, cv::Mat &dst);
+
+// Per-pixel median of the newest `frames` frames (odd, at most 9); removes
+// noise and things that pass quickly without blurring edges
+int temporalMedian(FrameHistory &history, cv::Mat &dst, int frames);
+
+// Pixels that differ from the history mean (needs sums) by more than
+// threshold keep their colour with a red tint, the rest turn dim grey
+int motionHighlight(FrameHistory &history, cv::Mat &dst, int threshold);
+
+// Row i comes from the frame i * (frames - 1) / (rows - 1) back, so the
+// top is live and the bottom is `frames` frames old
+int slitScan(FrameHistory &history, cv::Mat &dst, int frames);
+
+#endif
@@ -0,0 +1,400 @@
+/**
+ * benchmark.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Times every filter, face detection and the depth model on synthetic
+ * frames at 480p, 720p, 1080p and 4K.
+ *
+ * usage: bench [--res 480p,1080p] [--only name] [--reps n] [--warmup n]
+ *              [--max-seconds s] [--threads n] [--image path]
+ *              [--kernels isa] [--json out.json]
+ * --image takes a picture or a .vraw recording (its middle frame), scaled
+ * to each resolution.
+ * Each case runs warm-up calls first, then up to --reps timed calls (fewer
+ * if a case would take longer than --max-seconds). Reports median, p99,
+ * mean and min per call, megapixels per second and frames per second at
+ * the median.
+ * Reduced-resolution cases (name@1/n, digitalFog@depth518) also report
+ * the PSNR of their output against the full-resolution version.
+ */
+
+#include "DA2Network.hpp"
+#include "faceDetect.h"
+#include "filterKernels.h"
+#include "filters.h"
+#include "parallel.h"
+#include "rawFrames.h"
+#include "scaledFilter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Resolution {
+  const char *name;
+  int width, height;
+};
+
+static const Resolution resolutions[] = {{"480p", 640, 480},
+                                         {"720p", 1280, 720},
+                                         {"1080p", 1920, 1080},
+                                         {"4K", 3840, 2160}};
+
+// Inputs shared by the cases at one resolution, made once per resolution
+struct BenchFrames {
+  cv::Mat frame, grey, sobelX, sobelY, edges, quantized, depth, dst;
+  cv::Mat smooth; // painterly's smoothing of frame
+  cv::Mat depthLow, depthUp; // depth at the model's 518x518, scaled back
+  std::vector<cv::Rect> faces;
+  ScaledBuffers scaled;
+};
+
+struct BenchCase {
+  const char *name;
+  std::function<void(BenchFrames &)> run;
+  // full-resolution version of run, for the PSNR of a reduced-size case
+  std::function<void(BenchFrames &)> reference;
+};
+
+struct BenchResult {
+  std::string name, resolution;
+  int width, height, reps;
+  double medianMs, p99Ms, meanMs, minMs, mpixPerSec;
+  double psnr; // against the reference, 0 = no reference
+};
+
+struct BenchOptions {
+  std::vector<std::string> resolutions = {"480p", "720p", "1080p", "4K"};
+  std::string only;  // run cases whose name contains this
+  std::string image; // image or .vraw to use instead of a synthetic frame
+  std::string json;
+  int reps = 50, warmup = 5;
+  double maxSeconds = 3.0;
+};
+
+// Smooth gradients, shapes with hard edges and sensor-like noise, so the
+// edge and quantize filters see something like a real frame
+static void syntheticFrame(cv::Size size, cv::Mat &frame) {
+  frame.create(size, CV_8UC3);
+  for (int i = 0; i < size.height; i++) {
+    cv::Vec3b *row = frame.ptr<cv::Vec3b>(i);
+    for (int j = 0; j < size.width; j++) {
+      row[j] = cv::Vec3b((uchar)(255 * j / size.width),
+                         (uchar)(255 * i / size.height),
+                         (uchar)(128 + 127 * ((i / 64 + j / 64) % 2)));
+    }
+  }
+  cv::RNG rng(12345);
+  int unit = std::max(1, size.width / 40);
+  for (int k = 0; k < 40; k++) {
+    cv::Point c(rng.uniform(0, size.width), rng.uniform(0, size.height));
+    cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256),
+                     rng.uniform(0, 256));
+    if (k % 2)
+      cv::circle(frame, c, rng.uniform(unit, 4 * unit), color, -1);
+    else
+      cv::rectangle(frame, cv::Rect(c.x, c.y, 3 * unit, 2 * unit), color, -1);
+  }
+  cv::Mat noise(size, CV_16SC3);
+  rng.fill(noise, cv::RNG::NORMAL, 0, 6);
+  cv::add(frame, noise, frame, cv::noArray(), CV_8U);
+}
+
+static void prepare(const Resolution &res, const BenchOptions &opts,
+                    BenchFrames &f) {
+  cv::Size size(res.width, res.height);
+  cv::Mat image;
+  RawFrameReader raw;
+  if (isRawFramePath(opts.image)) {
+    if (raw.open(opts.image) && raw.type() == CV_8UC3)
+      image = raw.frame(raw.frames() / 2);
+  } else if (!opts.image.empty()) {
+    image = cv::imread(opts.image);
+  }
+  if (image.data != NULL)
+    cv::resize(image, f.frame, size);
+  else
+    syntheticFrame(size, f.frame);
+
+  cv::cvtColor(f.frame, f.grey, cv::COLOR_BGR2GRAY);
+  sobelX3x3(f.frame, f.sobelX);
+  sobelY3x3(f.frame, f.sobelY);
+  sobelEdges3x3(f.frame, f.edges);
+  blurQuantize(f.frame, f.quantized, 10);
+  domainTransform(f.frame, f.smooth, 40.0f);
+
+  // depth grows toward the top of the frame, like a floor receding
+  f.depth.create(size, CV_8UC1);
+  for (int i = 0; i < size.height; i++)
+    f.depth.row(i).setTo(255 - 255 * i / size.height);
+  cv::resize(f.depth, f.depthLow, cv::Size(518, 518), 0, 0, cv::INTER_AREA);
+
+  f.faces = {cv::Rect(size.width / 3, size.height / 4, size.width / 4,
+                      size.height / 3)};
+}
+
+static std::vector<BenchCase> benchCases(DA2Network *net) {
+  std::vector<BenchCase> cases = {
+      {"greyscale", [](BenchFrames &f) { greyscale(f.frame, f.dst); }},
+      {"greyscalePlane",
+       [](BenchFrames &f) { greyscalePlane(f.frame, f.dst); }},
+      {"sepia", [](BenchFrames &f) { sepia(f.frame, f.dst); }},
+      {"blur5x5_1", [](BenchFrames &f) { blur5x5_1(f.frame, f.dst); }},
+      {"blur5x5_2", [](BenchFrames &f) { blur5x5_2(f.frame, f.dst); }},
+      {"blur5x5_3", [](BenchFrames &f) { blur5x5_3(f.frame, f.dst); }},
+      {"sobelX3x3", [](BenchFrames &f) { sobelX3x3(f.frame, f.dst); }},
+      {"sobelY3x3", [](BenchFrames &f) { sobelY3x3(f.frame, f.dst); }},
+      {"magnitude",
+       [](BenchFrames &f) { magnitude(f.sobelX, f.sobelY, f.dst); }},
+      {"sobelMagnitude3x3",
+       [](BenchFrames &f) { sobelMagnitude3x3(f.frame, f.dst); }},
+      {"sobelEdges3x3",
+       [](BenchFrames &f) { sobelEdges3x3(f.frame, f.dst); }},
+      {"quantize", [](BenchFrames &f) { quantize(f.frame, f.dst, 10); }},
+      {"blurQuantize",
+       [](BenchFrames &f) { blurQuantize(f.frame, f.dst, 10); }},
+      {"spotlight", [](BenchFrames &f) { spotlight(f.frame, f.dst, f.faces); }},
+      {"neonEdges", [](BenchFrames &f) { neonEdges(f.frame, f.dst); }},
+      {"domainTransform",
+       [](BenchFrames &f) { domainTransform(f.frame, f.dst); }},
+      {"cartoon", [](BenchFrames &f) { cartoon(f.frame, f.dst, 10); }},
+      {"painterly", [](BenchFrames &f) { painterly(f.frame, f.dst); }},
+      {"neonCompose",
+       [](BenchFrames &f) { neonCompose(f.frame, f.edges, f.dst); }},
+      {"cartoonCompose",
+       [](BenchFrames &f) { cartoonCompose(f.quantized, f.edges, f.dst); }},
+      {"painterlyCompose",
+       [](BenchFrames &f) { painterlyCompose(f.smooth, f.edges, f.dst); }},
+      {"digitalFog",
+       [](BenchFrames &f) { digitalFog(f.frame, f.depth, f.dst); }},
+      // low-res depth: resize then fog (two passes) vs sampled in the fog
+      {"resize+digitalFog",
+       [](BenchFrames &f) {
+         cv::resize(f.depthLow, f.depthUp, f.frame.size());
+         digitalFog(f.frame, f.depthUp, f.dst);
+       }},
+      {"digitalFog@depth518",
+       [](BenchFrames &f) { digitalFog(f.frame, f.depthLow, f.dst); },
+       [](BenchFrames &f) {
+         cv::resize(f.depthLow, f.depthUp, f.frame.size());
+         digitalFog(f.frame, f.depthUp, f.dst);
+       }},
+      {"depthToBgr",
+       [](BenchFrames &f) { depthToBgr(f.depth, f.frame.size(), f.dst); }},
+      {"depthToBgr@depth518",
+       [](BenchFrames &f) { depthToBgr(f.depthLow, f.frame.size(), f.dst); }},
+      {"detectFaces",
+       [](BenchFrames &f) {
+         std::vector<cv::Rect> faces;
+         detectFaces(f.grey, faces);
+       }},
+  };
+
+  // the expensive stylized filters at 1/2 and 1/4 size, upsampled
+  static const char *scaledNames[] = {
+      "cartoon@1/2", "cartoon@1/4",      "neonEdges@1/2",
+      "neonEdges@1/4", "blurQuantize@1/2", "blurQuantize@1/4"};
+  std::vector<FilterFn> full = {
+      [](cv::Mat &s, cv::Mat &d) { return cartoon(s, d, 10); },
+      [](cv::Mat &s, cv::Mat &d) { return neonEdges(s, d); },
+      [](cv::Mat &s, cv::Mat &d) { return blurQuantize(s, d, 10); }};
+  for (int k = 0; k < 6; k++) {
+    FilterFn fn = full[k / 2];
+    int scale = k % 2 ? 4 : 2;
+    cases.push_back(
+        {scaledNames[k],
+         [fn, scale](BenchFrames &f) {
+           processScaled(f.frame, f.dst, scale, fn, f.scaled);
+         },
+         [fn](BenchFrames &f) { fn(f.frame, f.dst); }});
+  }
+
+  if (net != nullptr)
+    cases.push_back({"DA2Network::process",
+                     [net](BenchFrames &f) { net->process(f.frame, f.dst); }});
+  return cases;
+}
+
+static BenchResult runCase(const BenchCase &c, const Resolution &res,
+                           BenchFrames &f, const BenchOptions &opts) {
+  typedef std::chrono::steady_clock Clock;
+  for (int i = 0; i < opts.warmup; i++)
+    c.run(f);
+
+  std::vector<double> ms;
+  auto start = Clock::now();
+  while ((int)ms.size() < opts.reps) {
+    auto t0 = Clock::now();
+    c.run(f);
+    auto t1 = Clock::now();
+    ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+    // slow cases stop early, but always get a few samples
+    if (ms.size() >= 5 &&
+        std::chrono::duration<double>(t1 - start).count() > opts.maxSeconds)
+      break;
+  }
+
+  std::sort(ms.begin(), ms.end());
+  BenchResult r;
+  r.name = c.name;
+  r.resolution = res.name;
+  r.width = res.width;
+  r.height = res.height;
+  r.reps = (int)ms.size();
+  r.medianMs = ms[ms.size() / 2];
+  // nearest-rank percentile
+  size_t p99 = (size_t)std::ceil(0.99 * ms.size());
+  r.p99Ms = ms[std::min(ms.size(), std::max<size_t>(p99, 1)) - 1];
+  double sum = 0;
+  for (double v : ms)
+    sum += v;
+  r.meanMs = sum / ms.size();
+  r.minMs = ms[0];
+  r.mpixPerSec = (double)res.width * res.height / 1e6 / (r.medianMs / 1000);
+
+  r.psnr = 0;
+  if (c.reference) {
+    cv::Mat out = f.dst.clone();
+    c.reference(f);
+    r.psnr = cv::PSNR(out, f.dst);
+  }
+  return r;
+}
+
+static void writeJson(const std::string &path,
+                      const std::vector<BenchResult> &results) {
+  std::ofstream out(path);
+  if (!out) {
+    std::cerr << "Unable to write " << path << std::endl;
+    return;
+  }
+  char stamp[32];
+  std::time_t now = std::time(nullptr);
+  std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S",
+                std::localtime(&now));
+
+  out << "{\n  \"timestamp\": \"" << stamp << "\",\n"
+      << "  \"blur_simd\": \"" << blurSimdPath() << "\",\n"
+      << "  \"filter_kernels\": \"" << filterKernels().name << "\",\n"
+      << "  \"filter_threads\": " << getFilterThreads() << ",\n"
+      << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    char line[512];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"resolution\": \"%s\", \"width\": %d, "
+             "\"height\": %d, \"reps\": %d, \"median_ms\": %.4f, "
+             "\"p99_ms\": %.4f, \"mean_ms\": %.4f, \"min_ms\": %.4f, "
+             "\"mpix_per_s\": %.2f, \"fps\": %.1f",
+             r.name.c_str(), r.resolution.c_str(), r.width, r.height, r.reps,
+             r.medianMs, r.p99Ms, r.meanMs, r.minMs, r.mpixPerSec,
+             1000.0 / r.medianMs);
+    out << line;
+    if (r.psnr > 0)
+      out << ", \"psnr_db\": " << r.psnr;
+    out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+  std::cout << "Wrote " << path << std::endl;
+}
+
+static bool parseBenchArgs(int argc, char *argv[], BenchOptions &opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << a << std::endl;
+      return false;
+    }
+    std::string v = argv[++i];
+    if (a == "--res") {
+      opts.resolutions.clear();
+      std::istringstream ss(v);
+      std::string r;
+      while (std::getline(ss, r, ','))
+        opts.resolutions.push_back(r);
+    } else if (a == "--only") {
+      opts.only = v;
+    } else if (a == "--reps") {
+      opts.reps = std::max(1, std::atoi(v.c_str()));
+    } else if (a == "--warmup") {
+      opts.warmup = std::max(0, std::atoi(v.c_str()));
+    } else if (a == "--max-seconds") {
+      opts.maxSeconds = std::atof(v.c_str());
+    } else if (a == "--threads") {
+      setFilterThreads(std::atoi(v.c_str()));
+    } else if (a == "--image") {
+      opts.image = v;
+    } else if (a == "--kernels") {
+      if (!setFilterKernels(v.c_str())) {
+        std::cerr << "Kernels not available: " << v << std::endl;
+        return false;
+      }
+    } else if (a == "--json") {
+      opts.json = v;
+    } else {
+      std::cerr << "Unknown option: " << a << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  BenchOptions opts;
+  if (!parseBenchArgs(argc, argv, opts)) {
+    printf("Usage: %s [--res 480p,720p,1080p,4K] [--only name] [--reps n] "
+           "[--warmup n] [--max-seconds s] [--threads n] [--image path|.vraw] "
+           "[--kernels baseline|avx2|avx512] [--json out.json]\n",
+           argv[0]);
+    return -1;
+  }
+
+  // the depth model is optional, its case is skipped without it
+  DA2Network net;
+  DA2Config cfg;
+  std::string modelPath = cfg.modelPath();
+  bool haveNet = !modelPath.empty() && net.init(modelPath, cfg);
+  if (!haveNet)
+    std::cout << "No depth model, skipping DA2Network::process" << std::endl;
+  std::vector<BenchCase> cases = benchCases(haveNet ? &net : nullptr);
+
+  printf("blur SIMD path %s, filter kernels %s, %d filter threads\n",
+         blurSimdPath(), filterKernels().name, getFilterThreads());
+  printf("%-20s %6s %5s %10s %10s %10s %10s %7s %8s\n", "case", "res",
+         "reps", "median ms", "p99 ms", "min ms", "MP/s", "fps", "PSNR dB");
+
+  std::vector<BenchResult> results;
+  BenchFrames frames;
+  for (const Resolution &res : resolutions) {
+    if (std::find(opts.resolutions.begin(), opts.resolutions.end(),
+                  res.name) == opts.resolutions.end())
+      continue;
+    prepare(res, opts, frames);
+    for (const BenchCase &c : cases) {
+      if (!opts.only.empty() &&
+          std::string(c.name).find(opts.only) == std::string::npos)
+        continue;
+      BenchResult r = runCase(c, res, frames, opts);
+      printf("%-20s %6s %5d %10.3f %10.3f %10.3f %10.1f %7.1f",
+             r.name.c_str(), r.resolution.c_str(), r.reps, r.medianMs,
+             r.p99Ms, r.minMs, r.mpixPerSec, 1000.0 / r.medianMs);
+      if (r.psnr > 0)
+        printf(" %8.2f", r.psnr);
+      printf("\n");
+      fflush(stdout);
+      results.push_back(r);
+    }
+  }
+
+  if (!opts.json.empty())
+    writeJson(opts.json, results);
+  return 0;
+}
@@ -0,0 +1,278 @@
+/**
+ * blurSimd.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Vectorized version of the separable 5x5 blur (blur5x5_3).
+ *
+ * Same math and borders as blur5x5_2, but the BGR row is treated as a flat
+ * byte array: the horizontal neighbours of a byte are 3 bytes apart. Sums
+ * are at most 10 * 255, so they fit 16-bit lanes, and x / 10 is computed
+ * as (x * 6554) >> 16, which is exact for x <= 2550.
+ * The SSE4.1/AVX2 path is chosen at runtime; arm64 always has NEON.
+ */
+
+#include "../include/filters.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLUR_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define BLUR_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*BlurRowH)(const uchar *src, uchar *dst, int n);
+typedef void (*BlurRowV)(const uchar *const t[5], uchar *dst, int n);
+
+// Scalar tails, also the whole row when no SIMD is available
+
+static inline void blurH_scalar(const uchar *s, uchar *d, int x, int end) {
+  for (; x < end; x++)
+    d[x] = (s[x - 6] + 2 * s[x - 3] + 4 * s[x] + 2 * s[x + 3] + s[x + 6]) / 10;
+}
+
+static inline void blurV_scalar(const uchar *const t[5], uchar *d, int x,
+                                int end) {
+  for (; x < end; x++)
+    d[x] = (t[0][x] + 2 * t[1][x] + 4 * t[2][x] + 2 * t[3][x] + t[4][x]) / 10;
+}
+
+// Each horizontal pass keeps the first and last 2 pixels (6 bytes) of src
+static void rowH_scalar(const uchar *s, uchar *d, int n) {
+  int end = n - 6;
+  std::memcpy(d, s, std::min(n, 6));
+  blurH_scalar(s, d, 6, end);
+  if (end > 6)
+    std::memcpy(d + end, s + end, 6);
+  else if (n > 6)
+    std::memcpy(d + 6, s + 6, n - 6);
+}
+
+static void rowV_scalar(const uchar *const t[5], uchar *d, int n) {
+  blurV_scalar(t, d, 0, n);
+}
+
+#ifdef BLUR_X86
+
+__attribute__((target("sse4.1"))) static inline __m128i
+blur16_sse(__m128i a, __m128i b, __m128i c, __m128i e, __m128i f) {
+  // a + 2b + 4c + 2e + f on 8 u16 lanes, then / 10
+  __m128i s = _mm_add_epi16(a, f);
+  s = _mm_add_epi16(s, _mm_slli_epi16(_mm_add_epi16(b, e), 1));
+  s = _mm_add_epi16(s, _mm_slli_epi16(c, 2));
+  return _mm_mulhi_epu16(s, _mm_set1_epi16(6554));
+}
+
+__attribute__((target("sse4.1"))) static inline __m128i load8(const uchar *p) {
+  return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)p));
+}
+
+__attribute__((target("sse4.1"))) static void rowH_sse41(const uchar *s,
+                                                         uchar *d, int n) {
+  int end = n - 6, x = 6;
+  if (end <= 6) {
+    rowH_scalar(s, d, n);
+    return;
+  }
+  std::memcpy(d, s, 6);
+  for (; x + 16 <= end; x += 16) {
+    __m128i lo = blur16_sse(load8(s + x - 6), load8(s + x - 3), load8(s + x),
+                            load8(s + x + 3), load8(s + x + 6));
+    __m128i hi =
+        blur16_sse(load8(s + x + 2), load8(s + x + 5), load8(s + x + 8),
+                   load8(s + x + 11), load8(s + x + 14));
+    _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(lo, hi));
+  }
+  blurH_scalar(s, d, x, end);
+  std::memcpy(d + end, s + end, 6);
+}
+
+__attribute__((target("sse4.1"))) static void
+rowV_sse41(const uchar *const t[5], uchar *d, int n) {
+  int x = 0;
+  for (; x + 16 <= n; x += 16) {
+    __m128i lo = blur16_sse(load8(t[0] + x), load8(t[1] + x), load8(t[2] + x),
+                            load8(t[3] + x), load8(t[4] + x));
+    __m128i hi =
+        blur16_sse(load8(t[0] + x + 8), load8(t[1] + x + 8),
+                   load8(t[2] + x + 8), load8(t[3] + x + 8), load8(t[4] + x + 8));
+    _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(lo, hi));
+  }
+  blurV_scalar(t, d, x, n);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+blur32_avx2(__m256i a, __m256i b, __m256i c, __m256i e, __m256i f) {
+  __m256i s = _mm256_add_epi16(a, f);
+  s = _mm256_add_epi16(s, _mm256_slli_epi16(_mm256_add_epi16(b, e), 1));
+  s = _mm256_add_epi16(s, _mm256_slli_epi16(c, 2));
+  return _mm256_mulhi_epu16(s, _mm256_set1_epi16(6554));
+}
+
+__attribute__((target("avx2"))) static inline __m256i load16(const uchar *p) {
+  return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+// 16 u16 results back to 16 bytes, keeping lane order
+__attribute__((target("avx2"))) static inline void store16(uchar *p,
+                                                           __m256i v) {
+  __m128i r = _mm_packus_epi16(_mm256_castsi256_si128(v),
+                               _mm256_extracti128_si256(v, 1));
+  _mm_storeu_si128((__m128i *)p, r);
+}
+
+__attribute__((target("avx2"))) static void rowH_avx2(const uchar *s,
+                                                      uchar *d, int n) {
+  int end = n - 6, x = 6;
+  if (end <= 6) {
+    rowH_scalar(s, d, n);
+    return;
+  }
+  std::memcpy(d, s, 6);
+  for (; x + 16 <= end; x += 16) {
+    store16(d + x, blur32_avx2(load16(s + x - 6), load16(s + x - 3),
+                               load16(s + x), load16(s + x + 3),
+                               load16(s + x + 6)));
+  }
+  blurH_scalar(s, d, x, end);
+  std::memcpy(d + end, s + end, 6);
+}
+
+__attribute__((target("avx2"))) static void
+rowV_avx2(const uchar *const t[5], uchar *d, int n) {
+  int x = 0;
+  for (; x + 16 <= n; x += 16) {
+    store16(d + x, blur32_avx2(load16(t[0] + x), load16(t[1] + x),
+                               load16(t[2] + x), load16(t[3] + x),
+                               load16(t[4] + x)));
+  }
+  blurV_scalar(t, d, x, n);
+}
+
+#endif // BLUR_X86
+
+#ifdef BLUR_NEON
+
+static inline uint8x8_t blur8_neon(uint8x8_t a, uint8x8_t b, uint8x8_t c,
+                                   uint8x8_t e, uint8x8_t f) {
+  uint16x8_t s = vaddl_u8(a, f);
+  s = vaddq_u16(s, vshlq_n_u16(vaddl_u8(b, e), 1));
+  s = vaddq_u16(s, vshll_n_u8(c, 2));
+  uint16x4_t k = vdup_n_u16(6554);
+  uint32x4_t lo = vmull_u16(vget_low_u16(s), k);
+  uint32x4_t hi = vmull_u16(vget_high_u16(s), k);
+  return vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)));
+}
+
+static void rowH_neon(const uchar *s, uchar *d, int n) {
+  int end = n - 6, x = 6;
+  if (end <= 6) {
+    rowH_scalar(s, d, n);
+    return;
+  }
+  std::memcpy(d, s, 6);
+  for (; x + 8 <= end; x += 8) {
+    vst1_u8(d + x, blur8_neon(vld1_u8(s + x - 6), vld1_u8(s + x - 3),
+                              vld1_u8(s + x), vld1_u8(s + x + 3),
+                              vld1_u8(s + x + 6)));
+  }
+  blurH_scalar(s, d, x, end);
+  std::memcpy(d + end, s + end, 6);
+}
+
+static void rowV_neon(const uchar *const t[5], uchar *d, int n) {
+  int x = 0;
+  for (; x + 8 <= n; x += 8) {
+    vst1_u8(d + x, blur8_neon(vld1_u8(t[0] + x), vld1_u8(t[1] + x),
+                              vld1_u8(t[2] + x), vld1_u8(t[3] + x),
+                              vld1_u8(t[4] + x)));
+  }
+  blurV_scalar(t, d, x, n);
+}
+
+#endif // BLUR_NEON
+
+struct BlurPath {
+  const char *name;
+  BlurRowH h;
+  BlurRowV v;
+};
+
+static BlurPath bestPath() {
+#if defined(BLUR_X86)
+  if (__builtin_cpu_supports("avx2"))
+    return {"avx2", rowH_avx2, rowV_avx2};
+  if (__builtin_cpu_supports("sse4.1"))
+    return {"sse4.1", rowH_sse41, rowV_sse41};
+#elif defined(BLUR_NEON)
+  return {"neon", rowH_neon, rowV_neon};
+#endif
+  return {"scalar", rowH_scalar, rowV_scalar};
+}
+
+static BlurPath &currentPath() {
+  static BlurPath path = bestPath();
+  return path;
+}
+
+const char *blurSimdPath() { return currentPath().name; }
+
+bool setBlurSimdPath(const char *name) {
+  BlurPath p = {"scalar", rowH_scalar, rowV_scalar};
+  if (std::strcmp(name, "scalar") == 0) {
+    currentPath() = p;
+    return true;
+  }
+#if defined(BLUR_X86)
+  if (std::strcmp(name, "sse4.1") == 0 && __builtin_cpu_supports("sse4.1")) {
+    currentPath() = {"sse4.1", rowH_sse41, rowV_sse41};
+    return true;
+  }
+  if (std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+    currentPath() = {"avx2", rowH_avx2, rowV_avx2};
+    return true;
+  }
+#elif defined(BLUR_NEON)
+  if (std::strcmp(name, "neon") == 0) {
+    currentPath() = {"neon", rowH_neon, rowV_neon};
+    return true;
+  }
+#endif
+  return false;
+}
+
+// Vectorized separable 5x5 blur, same output as blur5x5_2
+int blur5x5_3(cv::Mat &src, cv::Mat &dst) {
+  cv::Mat in = (src.data == dst.data) ? src.clone() : src;
+  dst.create(in.size(), in.type());
+  int rows = in.rows, n = in.cols * 3;
+  BlurPath path = currentPath();
+
+  parallelRows(rows, [&](int r0, int r1) {
+    // 5 horizontally blurred rows, reused as a rolling window
+    thread_local std::vector<uchar> window;
+    window.resize(5 * (size_t)n);
+    auto hRow = [&](int i) { return window.data() + (size_t)(i % 5) * n; };
+
+    int v0 = std::max(r0, 2), v1 = std::min(r1, rows - 2);
+    for (int i = r0; i < r1; i++) {
+      if (i < v0 || i >= v1)
+        std::memcpy(dst.ptr(i), in.ptr(i), n);
+    }
+    if (v0 >= v1)
+      return;
+
+    for (int i = v0 - 2; i < v0 + 2; i++)
+      path.h(in.ptr(i), hRow(i), n);
+    for (int i = v0; i < v1; i++) {
+      path.h(in.ptr(i + 2), hRow(i + 2), n);
+      const uchar *t[5] = {hRow(i - 2), hRow(i - 1), hRow(i), hRow(i + 1),
+                           hRow(i + 2)};
+      path.v(t, dst.ptr(i), n);
+    }
+  });
+  return 0;
+}
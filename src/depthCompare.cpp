@@ -0,0 +1,265 @@
+/**
+ * depthCompare.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Compares a reference (FP32) and a test (usually INT8) depth model.
+ *
+ * usage: depthcmp <image dir> [ref model] [test model] [-t threads]
+ *                 [-s input size] [-n runs] [--csv file]
+ * Models are names like vits / vits_int8 (looked up in data/) or paths.
+ * For every image it prints the latency of both models, the AbsRel of the
+ * test model's raw output against the reference (after a least-squares
+ * scale and shift, since the output is relative depth) and the PSNR of the
+ * normalized 8-bit map that digitalFog uses. Peak memory is per model.
+ */
+
+#include "DA2Network.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+struct ModelRun {
+  std::string path;
+  std::vector<double> ms; // median latency per image
+  double peakMB = 0;      // peak resident memory above the baseline
+};
+
+// Resident memory in MB from /proc (Linux); the peak can be reset there
+static double procStatusMB(const char *key) {
+  std::ifstream in("/proc/self/status");
+  std::string line;
+  size_t n = std::strlen(key);
+  while (std::getline(in, line)) {
+    if (line.compare(0, n, key) == 0)
+      return std::atof(line.c_str() + n + 1) / 1024.0;
+  }
+  return -1;
+}
+
+static bool resetPeakRss() {
+  std::ofstream out("/proc/self/clear_refs");
+  out << "5";
+  return out.good();
+}
+
+static double peakRssMB() {
+  double mb = procStatusMB("VmHWM");
+  if (mb >= 0)
+    return mb;
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+  return ru.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+  return ru.ru_maxrss / 1024.0; // KB
+#endif
+}
+
+static std::string findModel(const std::string &name) {
+  DA2Config cfg;
+  cfg.model = name;
+  return cfg.modelPath();
+}
+
+// Runs one model over all images. onResult gets the raw output and the
+// 8-bit map of the last run on each image.
+template <typename F>
+static bool runModel(ModelRun &run, const DA2Config &cfg,
+                     std::vector<cv::Mat> &images, int runs, F onResult) {
+  bool canReset = resetPeakRss();
+  double baseMB = canReset ? procStatusMB("VmRSS") : 0;
+
+  DA2Network net;
+  if (!net.init(run.path, cfg))
+    return false;
+
+  cv::Mat depth;
+  for (int i = 0; i < 2; i++)
+    net.process(images[0], depth);
+
+  for (size_t i = 0; i < images.size(); i++) {
+    std::vector<double> ms;
+    for (int r = 0; r < runs; r++) {
+      auto t0 = std::chrono::steady_clock::now();
+      if (!net.process(images[i], depth))
+        return false;
+      ms.push_back(std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - t0)
+                       .count());
+    }
+    std::sort(ms.begin(), ms.end());
+    run.ms.push_back(ms[ms.size() / 2]);
+    onResult(i, net.rawDepth(), depth);
+  }
+
+  run.peakMB = peakRssMB() - baseMB;
+  if (!canReset)
+    std::cout << "Note: peak memory is for the whole process so far"
+              << std::endl;
+  return true;
+}
+
+// Mean |a*t + b - r| / r after fitting a and b by least squares. Pixels
+// with near-zero reference (far background) are left out.
+static double absRel(const cv::Mat &ref, const cv::Mat &test) {
+  double maxR;
+  cv::minMaxLoc(ref, nullptr, &maxR);
+  double eps = 0.01 * maxR;
+
+  double stt = 0, st = 0, str = 0, sr = 0, n = 0;
+  for (int y = 0; y < ref.rows; y++) {
+    const float *r = ref.ptr<float>(y);
+    const float *t = test.ptr<float>(y);
+    for (int x = 0; x < ref.cols; x++) {
+      if (r[x] <= eps)
+        continue;
+      stt += (double)t[x] * t[x];
+      st += t[x];
+      str += (double)t[x] * r[x];
+      sr += r[x];
+      n++;
+    }
+  }
+  if (n == 0)
+    return 0;
+  double det = stt * n - st * st;
+  double a = std::fabs(det) > 1e-12 ? (str * n - st * sr) / det : 1.0;
+  double b = std::fabs(det) > 1e-12 ? (stt * sr - st * str) / det : 0.0;
+
+  double sum = 0;
+  for (int y = 0; y < ref.rows; y++) {
+    const float *r = ref.ptr<float>(y);
+    const float *t = test.ptr<float>(y);
+    for (int x = 0; x < ref.cols; x++) {
+      if (r[x] > eps)
+        sum += std::fabs(a * t[x] + b - r[x]) / r[x];
+    }
+  }
+  return sum / n;
+}
+
+static double median(std::vector<double> v) {
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[v.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <image dir> [ref model] [test model] [-t threads] "
+           "[-s size] [-n runs] [--csv file]\n",
+           argv[0]);
+    return -1;
+  }
+
+  std::string dir = argv[1];
+  std::vector<std::string> models = {"vits", "vits_int8"};
+  std::string csvPath;
+  DA2Config cfg;
+  int runs = 3, named = 0;
+  for (int i = 2; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "-t" && hasValue)
+      cfg.intraThreads = std::max(1, std::atoi(argv[++i]));
+    else if (a == "-s" && hasValue)
+      cfg.inputSize = std::atoi(argv[++i]);
+    else if (a == "-n" && hasValue)
+      runs = std::max(1, std::atoi(argv[++i]));
+    else if (a == "--csv" && hasValue)
+      csvPath = argv[++i];
+    else if (a[0] != '-' && named < 2)
+      models[named++] = a;
+    else {
+      std::cerr << "Unknown argument: " << a << std::endl;
+      return -1;
+    }
+  }
+
+  std::vector<cv::String> files;
+  cv::glob(dir + "/*", files);
+  std::vector<std::string> names;
+  std::vector<cv::Mat> images;
+  for (const auto &f : files) {
+    cv::Mat img = cv::imread(f);
+    if (img.data == NULL)
+      continue;
+    names.push_back(f.substr(f.find_last_of('/') + 1));
+    images.push_back(img);
+  }
+  if (images.empty()) {
+    std::cerr << "No images in " << dir << std::endl;
+    return -1;
+  }
+
+  ModelRun ref, test;
+  ref.path = findModel(models[0]);
+  test.path = findModel(models[1]);
+  if (ref.path.empty() || test.path.empty()) {
+    std::cerr << "Model not found: "
+              << (ref.path.empty() ? models[0] : models[1]) << std::endl;
+    return -1;
+  }
+
+  // reference pass keeps its outputs for the comparison
+  std::vector<cv::Mat> refRaw(images.size()), refMap(images.size());
+  bool ok = runModel(ref, cfg, images, runs,
+                     [&](size_t i, const cv::Mat &raw, const cv::Mat &map) {
+                       raw.copyTo(refRaw[i]);
+                       map.copyTo(refMap[i]);
+                     });
+
+  std::vector<double> rel(images.size()), psnr(images.size());
+  cv::Mat resized;
+  ok = ok && runModel(test, cfg, images, runs,
+                      [&](size_t i, const cv::Mat &raw, const cv::Mat &map) {
+                        const cv::Mat *t = &raw;
+                        if (raw.size() != refRaw[i].size()) {
+                          cv::resize(raw, resized, refRaw[i].size());
+                          t = &resized;
+                        }
+                        rel[i] = absRel(refRaw[i], *t);
+                        psnr[i] = cv::PSNR(refMap[i], map);
+                      });
+  if (!ok) {
+    std::cerr << "Depth model failed to load or run" << std::endl;
+    return -1;
+  }
+
+  std::ofstream csv;
+  if (!csvPath.empty()) {
+    csv.open(csvPath);
+    csv << "image,ref_ms,test_ms,absrel,psnr_db\n";
+  }
+  printf("%-24s %10s %10s %8s %9s\n", "image", "ref ms", "test ms", "AbsRel",
+         "PSNR dB");
+  for (size_t i = 0; i < images.size(); i++) {
+    printf("%-24s %10.1f %10.1f %8.4f %9.2f\n", names[i].c_str(), ref.ms[i],
+           test.ms[i], rel[i], psnr[i]);
+    if (csv.is_open())
+      csv << names[i] << "," << ref.ms[i] << "," << test.ms[i] << ","
+          << rel[i] << "," << psnr[i] << "\n";
+  }
+
+  double meanRel = 0, meanPsnr = 0;
+  for (size_t i = 0; i < images.size(); i++) {
+    meanRel += rel[i] / images.size();
+    meanPsnr += psnr[i] / images.size();
+  }
+  printf("\nref  %s\n  median %.1f ms  peak memory %.1f MB\n",
+         ref.path.c_str(), median(ref.ms), ref.peakMB);
+  printf("test %s\n  median %.1f ms  peak memory %.1f MB\n",
+         test.path.c_str(), median(test.ms), test.peakMB);
+  printf("speedup %.2fx  mean AbsRel %.4f  mean PSNR %.2f dB  "
+         "worst PSNR %.2f dB\n",
+         median(ref.ms) / std::max(1e-9, median(test.ms)), meanRel, meanPsnr,
+         *std::min_element(psnr.begin(), psnr.end()));
+  return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * depthService.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Asynchronous depth inference with reuse of the last finished map, and
+ * cross-stream batching of depth requests.
+ */
+
+#include "../include/depthService.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+DepthService::DepthService(DA2Network &net, const DepthPolicy &policy)
+    : net_(net), policy_(policy), running_(false), pendingFrame_(0),
+      hasPending_(false), resultFrame_(0), resultCount_(0), blendedCount_(0),
+      frameId_(0), lastSubmit_(0) {
+  if (policy_.inferEvery < 1)
+    policy_.inferEvery = 1;
+}
+
+DepthService::~DepthService() { stop(); }
+
+void DepthService::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_)
+    return;
+  running_ = true;
+  thread_ = std::thread(&DepthService::loop, this);
+}
+
+void DepthService::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  wake_.notify_all();
+  done_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void DepthService::loop() {
+  cv::Mat frame, depth;
+  for (;;) {
+    long id;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return hasPending_ || !running_; });
+      if (!running_)
+        return;
+      // take the newest frame and leave our old buffer for the next one
+      cv::swap(frame, pending_);
+      id = pendingFrame_;
+      hasPending_ = false;
+    }
+
+    bool ok = net_.process(frame, depth);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ok) {
+      cv::swap(result_, depth);
+      resultFrame_ = id;
+      resultCount_++;
+    }
+    done_.notify_all();
+  }
+}
+
+bool DepthService::update(const cv::Mat &frame, cv::Mat &depth) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  frameId_++;
+
+  // too old (or nothing yet with no staleness allowed): wait for the model
+  bool tooOld = resultCount_ > 0 &&
+                frameId_ - resultFrame_ > policy_.maxStaleness;
+  bool mustWait = tooOld || (resultCount_ == 0 && policy_.maxStaleness == 0);
+
+  // the wait ends when a newer map lands, so between inferEvery submits
+  // (staleness below inferEvery) this frame has to go to the model too
+  bool due = frameId_ - lastSubmit_ >= policy_.inferEvery || resultCount_ == 0;
+  if (due || (mustWait && lastSubmit_ <= resultFrame_)) {
+    frame.copyTo(pending_);
+    pendingFrame_ = frameId_;
+    hasPending_ = true;
+    lastSubmit_ = frameId_;
+    wake_.notify_one();
+  }
+
+  if (mustWait && running_) {
+    long seen = resultCount_;
+    done_.wait_for(lock, std::chrono::seconds(5),
+                   [&] { return resultCount_ != seen || !running_; });
+  }
+
+  if (resultCount_ == 0)
+    return false;
+
+  if (blendedCount_ != resultCount_) {
+    if (policy_.blend > 0 && blended_.size() == result_.size())
+      cv::addWeighted(blended_, policy_.blend, result_, 1.0 - policy_.blend,
+                      0, blended_);
+    else
+      result_.copyTo(blended_);
+    blendedCount_ = resultCount_;
+  }
+
+  if (blended_.size() == frame.size() || net_.config().lowResOutput)
+    blended_.copyTo(depth);
+  else
+    cv::resize(blended_, depth, frame.size());
+  return true;
+}
+
+long DepthService::staleness() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return frameId_ - resultFrame_;
+}
+
+long DepthService::inferences() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resultCount_;
+}
+
+DepthBatcher::DepthBatcher(DA2Network &net, int maxBatch, int waitMs)
+    : net_(net), maxBatch_(std::max(1, maxBatch)),
+      waitMs_(std::max(0, waitMs)), running_(false), batches_(0),
+      frames_(0) {}
+
+DepthBatcher::~DepthBatcher() { stop(); }
+
+void DepthBatcher::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_)
+    return;
+  running_ = true;
+  thread_ = std::thread(&DepthBatcher::loop, this);
+}
+
+void DepthBatcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  wake_.notify_all();
+  done_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool DepthBatcher::process(const cv::Mat &frame, cv::Mat &depth) {
+  Request req = {&frame, &depth, false, false, false};
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!running_)
+    return false;
+  queue_.push_back(&req);
+  wake_.notify_one();
+  // once in a batch the loop still uses req, so wait for it even if stop()
+  // was called; stop() lets the running batch finish
+  done_.wait(lock, [&] { return req.done || (!running_ && !req.taken); });
+  if (!req.done) {
+    // stopped before our batch ran
+    queue_.erase(std::remove(queue_.begin(), queue_.end(), &req),
+                 queue_.end());
+    return false;
+  }
+  return req.ok;
+}
+
+void DepthBatcher::loop() {
+  std::vector<Request *> batch;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return !queue_.empty() || !running_; });
+      if (!running_)
+        return;
+      // give the other streams a moment to fill the batch
+      wake_.wait_for(lock, std::chrono::milliseconds(waitMs_), [&] {
+        return (int)queue_.size() >= maxBatch_ || !running_;
+      });
+      if (!running_)
+        return;
+      size_t n = std::min(queue_.size(), (size_t)maxBatch_);
+      batch.assign(queue_.begin(), queue_.begin() + n);
+      queue_.erase(queue_.begin(), queue_.begin() + n);
+      for (Request *r : batch)
+        r->taken = true;
+    }
+
+    // requesters are blocked until done, so their frames stay valid
+    srcs_.resize(batch.size());
+    dsts_.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+      srcs_[i] = *batch[i]->frame;
+      cv::swap(dsts_[i], *batch[i]->depth);
+    }
+    bool ok = net_.processBatch(srcs_, dsts_);
+    for (auto &m : srcs_)
+      m.release();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < batch.size(); i++) {
+      cv::swap(dsts_[i], *batch[i]->depth);
+      batch[i]->ok = ok;
+      batch[i]->done = true;
+    }
+    batches_++;
+    frames_ += batch.size();
+    done_.notify_all();
+  }
+}
+
+long DepthBatcher::batches() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return batches_;
+}
+
+long DepthBatcher::frames() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return frames_;
+}
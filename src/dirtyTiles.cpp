@@ -0,0 +1,143 @@
+/**
+ * dirtyTiles.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Change detection per tile and filtering of the changed tiles only.
+ */
+
+#include "../include/dirtyTiles.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+DirtyTileFilter::DirtyTileFilter(const DirtyTileConfig &config)
+    : tilesX_(0), tilesY_(0), sinceRefresh_(0), lastFraction_(0),
+      tilesDone_(0), tilesTotal_(0) {
+  setConfig(config);
+}
+
+void DirtyTileFilter::setConfig(const DirtyTileConfig &config) {
+  config_ = config;
+  config_.tile = std::max(8, config_.tile);
+  reset();
+}
+
+void DirtyTileFilter::reset() {
+  ref_.release();
+  out_.release();
+}
+
+// A tile's output depends on its pixels and on `halo` pixels of its
+// neighbours, so changes are counted over each tile grown by halo: a
+// change near a tile edge makes both tiles dirty.
+void DirtyTileFilter::findDirty(const cv::Mat &src, int halo) {
+  int t = config_.tile, cn = src.channels();
+  std::unique_ptr<std::atomic<int>[]> counts(
+      new std::atomic<int>[tilesX_ * tilesY_]);
+  for (int k = 0; k < tilesX_ * tilesY_; k++)
+    counts[k].store(0, std::memory_order_relaxed);
+
+  parallelRows(src.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uchar *s = src.ptr<uchar>(i);
+      const uchar *r = ref_.ptr<uchar>(i);
+      // tile rows whose grown rectangle holds row i
+      int ty0 = std::max(0, (i - halo) / t);
+      int ty1 = std::min(tilesY_ - 1, (i + halo) / t);
+      for (int tx = 0; tx < tilesX_; tx++) {
+        int j0 = std::max(0, tx * t - halo) * cn;
+        int j1 = std::min(src.cols, (tx + 1) * t + halo) * cn;
+        int n = 0;
+        for (int j = j0; j < j1; j++)
+          n += std::abs(s[j] - r[j]) > config_.threshold;
+        if (n > 0)
+          for (int ty = ty0; ty <= ty1; ty++)
+            counts[ty * tilesX_ + tx].fetch_add(n, std::memory_order_relaxed);
+      }
+    }
+  });
+
+  changed_.resize(tilesX_ * tilesY_);
+  for (int k = 0; k < tilesX_ * tilesY_; k++)
+    changed_[k] = counts[k].load(std::memory_order_relaxed);
+}
+
+int DirtyTileFilter::apply(cv::Mat &src, cv::Mat &dst, const FilterFn &fn,
+                           int halo) {
+  int t = config_.tile;
+  bool full = out_.empty() || ref_.size() != src.size() ||
+              ref_.type() != src.type() ||
+              (config_.refreshEvery > 0 &&
+               ++sinceRefresh_ >= config_.refreshEvery);
+
+  tilesX_ = (src.cols + t - 1) / t;
+  tilesY_ = (src.rows + t - 1) / t;
+  int tiles = tilesX_ * tilesY_;
+  tilesTotal_ += tiles;
+
+  if (full) {
+    int ret = fn(src, out_);
+    if (ret != 0)
+      return ret;
+    src.copyTo(ref_);
+    out_.copyTo(dst);
+    sinceRefresh_ = 0;
+    tilesDone_ += tiles;
+    lastFraction_ = 1;
+    return 0;
+  }
+
+  findDirty(src, std::max(0, halo));
+
+  // runs of dirty tiles along each tile row become one rectangle
+  rects_.clear();
+  int dirty = 0;
+  for (int ty = 0; ty < tilesY_; ty++) {
+    for (int tx = 0; tx < tilesX_; tx++) {
+      if (changed_[ty * tilesX_ + tx] <= config_.minChanged)
+        continue;
+      int end = tx;
+      while (end + 1 < tilesX_ &&
+             changed_[ty * tilesX_ + end + 1] > config_.minChanged)
+        end++;
+      cv::Rect r(tx * t, ty * t, (end + 1 - tx) * t, t);
+      rects_.push_back(r & cv::Rect(0, 0, src.cols, src.rows));
+      dirty += end + 1 - tx;
+      tx = end;
+    }
+  }
+
+  if (scratch_.size() < rects_.size())
+    scratch_.resize(rects_.size());
+  // rectangles in parallel; the filters' own parallelRows runs serially
+  // inside, as OpenCV does not nest parallel regions
+  std::atomic<int> failed(0);
+  auto body = [&](const cv::Range &range) {
+    for (int k = range.start; k < range.end; k++) {
+      const cv::Rect &r = rects_[k];
+      cv::Rect grown(r.x - halo, r.y - halo, r.width + 2 * halo,
+                     r.height + 2 * halo);
+      grown &= cv::Rect(0, 0, src.cols, src.rows);
+      cv::Mat in = src(grown);
+      if (fn(in, scratch_[k]) != 0) {
+        failed++;
+        continue;
+      }
+      cv::Rect inner(r.x - grown.x, r.y - grown.y, r.width, r.height);
+      cv::Mat outTile = out_(r), refTile = ref_(r); // views, written in place
+      scratch_[k](inner).copyTo(outTile);
+      src(r).copyTo(refTile);
+    }
+  };
+  cv::parallel_for_(cv::Range(0, (int)rects_.size()), body);
+  if (failed.load() > 0) {
+    reset();
+    return -1;
+  }
+
+  out_.copyTo(dst);
+  tilesDone_ += dirty;
+  lastFraction_ = tiles > 0 ? (double)dirty / tiles : 0;
+  return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * domainTransform.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Edge-preserving smoothing with the recursive domain transform filter
+ * (Gastal and Oliveira, 2011), used by cartoon and painterly.
+ *
+ * Every iteration runs a first-order recursive filter along each row (left
+ * to right and back) and then each column (down and up). The feedback
+ * weight between two neighbours is a^(1 + sigmaS / sigmaR * diff), where
+ * diff is their summed channel difference, so the smoothing stops at edges
+ * and costs the same per pixel for any sigmaS. diff is an integer 0..765,
+ * so an iteration's weights come from one table.
+ * Rows are split across threads for the horizontal passes and columns for
+ * the vertical ones. The vertical passes update whole rows of floats at a
+ * time through the filterKernels recursiveRow kernel.
+ */
+
+#include "../include/filterKernels.h"
+#include "../include/filters.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+static const int MAX_DIFF = 3 * 255;
+
+static inline int colourDiff(const uchar *a, const uchar *b) {
+  return std::abs(a[0] - b[0]) + std::abs(a[1] - b[1]) +
+         std::abs(a[2] - b[2]);
+}
+
+// Recursive filter along G rows, left to right and back. Each row is one
+// long chain of dependent steps; running G rows in the same loop gives the
+// CPU independent work to overlap (about twice as fast with 4 rows).
+template <int G>
+static void rowPass(float *const *w, const uint16_t *const *h, int cols,
+                    const float *lut) {
+  for (int j = 1; j < cols; j++) {
+    for (int q = 0; q < G; q++) {
+      float f = lut[h[q][j]];
+      float *p = w[q] + 3 * j;
+      p[0] += f * (p[-3] - p[0]);
+      p[1] += f * (p[-2] - p[1]);
+      p[2] += f * (p[-1] - p[2]);
+    }
+  }
+  for (int j = cols - 2; j >= 0; j--) {
+    for (int q = 0; q < G; q++) {
+      float f = lut[h[q][j + 1]];
+      float *p = w[q] + 3 * j;
+      p[0] += f * (p[3] - p[0]);
+      p[1] += f * (p[4] - p[1]);
+      p[2] += f * (p[5] - p[2]);
+    }
+  }
+}
+
+int domainTransform(cv::Mat &src, cv::Mat &dst, float sigmaS, float sigmaR,
+                    int iterations) {
+  if (src.empty() || src.type() != CV_8UC3)
+    return -1;
+  int rows = src.rows, cols = src.cols, n = cols * 3;
+  iterations = std::max(1, std::min(iterations, 5));
+  sigmaS = std::max(sigmaS, 0.5f);
+  sigmaR = std::max(sigmaR, 0.5f);
+
+  // per calling thread, so pipeline workers never share them and a frame
+  // allocates nothing after the first
+  thread_local cv::Mat work, dx, dy;
+  work.create(rows, n, CV_32FC1);
+  dx.create(rows, cols, CV_16UC1); // diff to the left neighbour
+  dy.create(rows, cols, CV_16UC1); // diff to the neighbour above
+
+  parallelRows(rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uchar *s = src.ptr<uchar>(i);
+      const uchar *up = src.ptr<uchar>(std::max(i - 1, 0));
+      float *w = work.ptr<float>(i);
+      uint16_t *h = dx.ptr<uint16_t>(i);
+      uint16_t *v = dy.ptr<uint16_t>(i);
+      for (int k = 0; k < n; k++)
+        w[k] = s[k];
+      h[0] = 0;
+      for (int j = 1; j < cols; j++)
+        h[j] = (uint16_t)colourDiff(s + 3 * j, s + 3 * j - 3);
+      for (int j = 0; j < cols; j++)
+        v[j] = (uint16_t)colourDiff(s + 3 * j, up + 3 * j);
+    }
+  });
+
+  std::vector<float> lut(MAX_DIFF + 1);
+  for (int it = 0; it < iterations; it++) {
+    // each iteration narrower, so together they give a spread of sigmaS
+    double sigmaH = sigmaS * std::sqrt(3.0) *
+                    std::pow(2.0, iterations - it - 1) /
+                    std::sqrt(std::pow(4.0, iterations) - 1);
+    double a = std::exp(-std::sqrt(2.0) / sigmaH);
+    for (int d = 0; d <= MAX_DIFF; d++)
+      lut[d] = (float)std::pow(a, 1.0 + sigmaS / sigmaR * d);
+
+    parallelRows(rows, [&](int r0, int r1) {
+      float *w[4];
+      const uint16_t *h[4];
+      int i = r0;
+      for (; i + 4 <= r1; i += 4) {
+        for (int q = 0; q < 4; q++) {
+          w[q] = work.ptr<float>(i + q);
+          h[q] = dx.ptr<uint16_t>(i + q);
+        }
+        rowPass<4>(w, h, cols, lut.data());
+      }
+      for (; i < r1; i++) {
+        w[0] = work.ptr<float>(i);
+        h[0] = dx.ptr<uint16_t>(i);
+        rowPass<1>(w, h, cols, lut.data());
+      }
+    });
+
+    // bands of columns; every row of a band is one kernel call
+    parallelRows(cols, [&](int c0, int c1) {
+      const FilterKernels &k = filterKernels();
+      int len = (c1 - c0) * 3;
+      std::vector<float> weight(len);
+      auto step = [&](int i, int from, int diffRow) {
+        const uint16_t *v = dy.ptr<uint16_t>(diffRow) + c0;
+        for (int j = 0; j < c1 - c0; j++)
+          weight[3 * j] = weight[3 * j + 1] = weight[3 * j + 2] = lut[v[j]];
+        k.recursiveRow(work.ptr<float>(i) + 3 * c0,
+                       work.ptr<float>(from) + 3 * c0, weight.data(), len);
+      };
+      for (int i = 1; i < rows; i++)
+        step(i, i - 1, i);
+      for (int i = rows - 2; i >= 0; i--)
+        step(i, i + 1, i + 1);
+    });
+  }
+
+  // every step mixes two values in [0, 255], so no clamping is needed
+  dst.create(src.size(), CV_8UC3);
+  parallelRows(rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const float *w = work.ptr<float>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int k = 0; k < n; k++)
+        d[k] = (uchar)(w[k] + 0.5f);
+    }
+  });
+  return 0;
+}
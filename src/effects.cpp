@@ -0,0 +1,434 @@
+/**
+ * effects.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Maps a mode key to the filter chain that produces the display frame.
+ */
+
+#include "../include/effects.h"
+#include "DA2Network.hpp"
+#include "depthService.h"
+#include "faceDetect.h"
+#include "filters.h"
+#include "stageTimer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+static DA2Network *depthNetwork = nullptr;
+static DA2Config depthConfig;
+static bool depthNetworkLoaded = false;
+static bool depthModelWarned = false;
+static bool asyncDepth = false;
+static DepthPolicy depthPolicy;
+static DepthService *depthService = nullptr;
+static int depthBatch = 1, depthBatchWaitMs = 5;
+static DepthBatcher *depthBatcher = nullptr;
+static FaceDetectorConfig faceConfig;
+static TemporalConfig temporalConfig;
+static FogStyle fogStyle;
+static bool dirtyTiles = false;
+static DirtyTileConfig dirtyConfig;
+static std::atomic<long> dirtyDone(0), dirtyTotal(0), dirtyFrames(0);
+
+// the depth network keeps shared state, so pipeline workers take turns on it
+static std::mutex depthMutex;
+
+static std::string effectChain = "cartoon";
+
+// per mode key, 0 = full resolution
+static int processScale[128];
+
+bool setEffectChain(const std::string &spec) {
+  FilterGraph check;
+  if (check.addChain(spec) < 0)
+    return false;
+  effectChain = spec;
+  return true;
+}
+
+bool isEffectKey(char key) {
+  return key != 0 && std::strchr(EFFECT_KEYS, key) != nullptr;
+}
+
+bool ensureDepthNetwork() {
+  if (depthNetworkLoaded)
+    return true;
+  if (depthModelWarned)
+    return false;
+
+  if (depthNetwork == nullptr) {
+    depthNetwork = new DA2Network();
+  }
+
+  std::string path = findDepthModel(depthConfig);
+  if (!path.empty() && depthNetwork->init(path, depthConfig)) {
+    depthNetworkLoaded = true;
+    return true;
+  }
+
+  depthModelWarned = true;
+  std::cerr << "Warning: No depth model " << depthConfig.modelFile()
+            << " found in data/" << std::endl;
+  return false;
+}
+
+void setDepthConfig(const DA2Config &config) { depthConfig = config; }
+
+void setFaceDetectorConfig(const FaceDetectorConfig &config) {
+  faceConfig = config;
+}
+
+void setTemporalConfig(const TemporalConfig &config) {
+  temporalConfig = config;
+}
+
+void setFogStyle(const FogStyle &style) { fogStyle = style; }
+
+void setDirtyTiles(const DirtyTileConfig &config) {
+  dirtyConfig = config;
+  dirtyTiles = true;
+}
+
+std::string findDepthModel(const DA2Config &config) {
+  return config.modelPath();
+}
+
+void setAsyncDepth(const DepthPolicy &policy) {
+  asyncDepth = true;
+  depthPolicy = policy;
+}
+
+bool setProcessingScale(char mode, int scale) {
+  if (!isEffectKey(mode) || (scale != 1 && scale != 2 && scale != 4))
+    return false;
+  processScale[(int)mode] = scale;
+  return true;
+}
+
+int processingScale(char mode) {
+  return isEffectKey(mode) ? std::max(1, processScale[(int)mode]) : 1;
+}
+
+void setDepthBatching(int maxBatch, int waitMs) {
+  depthBatch = maxBatch;
+  depthBatchWaitMs = waitMs;
+}
+
+void shutdownEffects() {
+  if (dirtyFrames.load() > 0)
+    std::cout << "Dirty tiles: "
+              << 100.0 * dirtyDone.load() / std::max(1L, dirtyTotal.load())
+              << "% recomputed over " << dirtyFrames.load() << " frames"
+              << std::endl;
+  std::lock_guard<std::mutex> lock(depthMutex);
+  if (depthBatcher != nullptr) {
+    long batches = depthBatcher->batches();
+    std::cout << "Depth batches: " << batches << ", "
+              << (batches > 0 ? (double)depthBatcher->frames() / batches : 0)
+              << " frames per batch" << std::endl;
+    delete depthBatcher;
+    depthBatcher = nullptr;
+  }
+  if (depthService != nullptr) {
+    std::cout << "Depth service: " << depthService->inferences()
+              << " inferences" << std::endl;
+    delete depthService;
+    depthService = nullptr;
+  }
+}
+
+static bool runDepth(cv::Mat &frame, cv::Mat &depthMap) {
+  std::unique_lock<std::mutex> lock(depthMutex);
+  if (!ensureDepthNetwork())
+    return false;
+
+  // batched: wait for the next batch without holding the lock, so other
+  // streams can add their frames to it
+  if (depthBatch > 1) {
+    if (depthBatcher == nullptr) {
+      depthBatcher =
+          new DepthBatcher(*depthNetwork, depthBatch, depthBatchWaitMs);
+      depthBatcher->start();
+    }
+    DepthBatcher *batcher = depthBatcher;
+    lock.unlock();
+    return batcher->process(frame, depthMap);
+  }
+
+  // async: the model runs on its own thread, we take its latest map
+  if (asyncDepth) {
+    if (depthService == nullptr) {
+      depthService = new DepthService(*depthNetwork, depthPolicy);
+      depthService->start();
+    }
+    return depthService->update(frame, depthMap);
+  }
+
+  if (!depthNetwork->process(frame, depthMap))
+    return false;
+
+  // average pre/post-processing vs inference time every 100 depth frames
+  static int count = 0;
+  static double pre = 0, infer = 0, post = 0;
+  pre += depthNetwork->preprocessMs();
+  infer += depthNetwork->inferenceMs();
+  post += depthNetwork->postprocessMs();
+  if (++count == 100) {
+    std::cout << "Depth ms/frame: pre " << pre / count << ", infer "
+              << infer / count << ", post " << post / count << std::endl;
+    count = 0;
+    pre = infer = post = 0;
+  }
+  return true;
+}
+
+// Modes built as filter graphs, so their intermediates come from the
+// graph's frame arena instead of being allocated every frame
+static const char *graphSpec(char mode) {
+  switch (mode) {
+  case '2':
+    return "neon";
+  case '3':
+    return "cartoon";
+  case 'a':
+    return "painterly";
+  case 'k':
+    return effectChain.c_str();
+  }
+  return nullptr;
+}
+
+static int runGraph(char mode, cv::Mat &frame, cv::Mat &dst,
+                    EffectState &state) {
+  if (state.graphMode != mode) {
+    state.graph.clear();
+    state.graph.setDepthFn(runDepth);
+    state.graph.setFogStyle(fogStyle);
+    state.graph.addChain(graphSpec(mode));
+    state.graphMode = mode;
+  }
+  return state.graph.run(frame, dst);
+}
+
+static void depthMissing(cv::Mat &frame, cv::Mat &dst) {
+  frame.copyTo(dst);
+  cv::putText(dst, "Depth model not loaded", cv::Point(10, 30),
+              cv::FONT_HERSHEY_SIMPLEX, 1, cv::Scalar(0, 0, 255), 2);
+}
+
+// One detector for all pipeline workers, it hands each caller its own
+// classifier
+static FaceDetector &sharedDetector() {
+  static FaceDetector detector(faceConfig);
+  return detector;
+}
+
+static int detectResult(bool ok) {
+  static std::once_flag reported;
+  if (ok)
+    return 0;
+  std::call_once(reported, [] {
+    std::cerr << sharedDetector().error() << std::endl;
+  });
+  return -1;
+}
+
+// Haar detection every few frames, template tracking in between
+static void trackFaces(EffectState &state) {
+  ScopedTimer timer(Stage::Faces);
+  const cv::Mat &grey = state.grey.grey();
+  FaceDetector &detector = sharedDetector();
+
+  // whole-frame detections take the frame's shared half-size equalized
+  // image; windows around lost faces are prepared by the detector
+  auto detect = [&](cv::Mat &img, std::vector<cv::Rect> &faces) {
+    if (img.data == grey.data && img.size() == grey.size())
+      return detectResult(detector.detectPrepared(
+          state.grey.equalized(detector.config().downscale), faces));
+    return detectResult(detector.detect(img, faces));
+  };
+  cv::Mat full = grey; // header, the tracker takes a non-const Mat
+  state.faceTracker.update(full, detect);
+  state.faceTracker.boxes(state.faces, state.faceIds);
+}
+
+// Modes 5-9 keep a history of this state's frames, resized when the mode
+// changes; each frame is added before the effect reads the history
+static int runTemporal(char mode, cv::Mat &frame, cv::Mat &dst,
+                       EffectState &state) {
+  const TemporalConfig &t = temporalConfig;
+  if (state.historyMode != mode) {
+    switch (mode) {
+    case '5':
+      state.history.configure(t.echoGap * t.echoes + 1, false);
+      break;
+    case '6':
+    case '7':
+      state.history.configure(t.averageFrames, true);
+      break;
+    case '8':
+      state.history.configure(t.slitFrames, false);
+      break;
+    case '9':
+      state.history.configure(t.medianFrames, false);
+      break;
+    }
+    state.historyMode = mode;
+  }
+  state.history.push(frame);
+
+  switch (mode) {
+  case '5':
+    return echoTrails(state.history, dst, t.echoGap, t.echoes);
+  case '6':
+    return temporalAverage(state.history, dst);
+  case '7':
+    return motionHighlight(state.history, dst, t.motionThreshold);
+  case '8':
+    return slitScan(state.history, dst, t.slitFrames);
+  case '9':
+    return temporalMedian(state.history, dst, t.medianFrames);
+  }
+  return -1;
+}
+
+// Filters of the tile-safe modes (no position dependence, no state) and
+// the radius of their kernels; false for other modes. Cartoon and
+// painterly are not: their smoothing reaches arbitrarily far along a row.
+static bool tileFilter(char mode, FilterFn &fn, int &halo) {
+  halo = 2; // 5x5 blur; the 3x3 sobel needs 1
+  switch (mode) {
+  case 'b':
+    fn = [](cv::Mat &s, cv::Mat &d) { return blur5x5_3(s, d); };
+    return true;
+  case 'm':
+    fn = [](cv::Mat &s, cv::Mat &d) { return sobelMagnitude3x3(s, d); };
+    return true;
+  case 'l':
+    fn = [](cv::Mat &s, cv::Mat &d) { return blurQuantize(s, d, 10); };
+    return true;
+  case '2':
+    fn = [](cv::Mat &s, cv::Mat &d) { return neonEdges(s, d); };
+    return true;
+  }
+  return false;
+}
+
+static bool runDirty(char mode, cv::Mat &frame, cv::Mat &dst,
+                     EffectState &state) {
+  FilterFn fn;
+  int halo;
+  if (!dirtyTiles || !tileFilter(mode, fn, halo))
+    return false;
+  if (state.dirtyMode != mode) {
+    state.dirty.setConfig(dirtyConfig);
+    state.dirtyMode = mode;
+  }
+  long done = state.dirty.tilesDone(), total = state.dirty.tilesTotal();
+  if (state.dirty.apply(frame, dst, fn, halo) != 0)
+    return false;
+  dirtyDone += state.dirty.tilesDone() - done;
+  dirtyTotal += state.dirty.tilesTotal() - total;
+  dirtyFrames++;
+  return true;
+}
+
+const cv::Mat &asBgr(const cv::Mat &frame, cv::Mat &scratch) {
+  if (frame.channels() == 3)
+    return frame;
+  cv::cvtColor(frame, scratch, cv::COLOR_GRAY2BGR);
+  return scratch;
+}
+
+static int runEffect(char mode, cv::Mat &frame, cv::Mat &dst,
+                     EffectState &state) {
+  state.grey.reset(frame);
+  if (runDirty(mode, frame, dst, state))
+    return 0;
+  switch (mode) {
+  case 'c':
+    frame.copyTo(dst);
+    break;
+  case 'g':
+    cv::cvtColor(frame, dst, cv::COLOR_BGR2GRAY);
+    break;
+  case 'h':
+    greyscalePlane(frame, dst);
+    break;
+  case 'p':
+    sepia(frame, dst);
+    break;
+  case 'b':
+    blur5x5_3(frame, dst);
+    break;
+  case 'x':
+    sobelX3x3(frame, state.sobelX);
+    cv::convertScaleAbs(state.sobelX, dst);
+    break;
+  case 'y':
+    sobelY3x3(frame, state.sobelY);
+    cv::convertScaleAbs(state.sobelY, dst);
+    break;
+  case 'm':
+    sobelMagnitude3x3(frame, dst);
+    break;
+  case 'l':
+    blurQuantize(frame, dst, 10);
+    break;
+  case 'f':
+    frame.copyTo(dst);
+    trackFaces(state);
+    drawBoxes(dst, state.faces, state.faceIds);
+    break;
+  case '1':
+    trackFaces(state);
+    spotlight(frame, dst, state.faces);
+    break;
+  case '2':
+  case '3':
+  case 'a':
+  case 'k':
+    runGraph(mode, frame, dst, state);
+    break;
+  case 'd':
+    if (runDepth(frame, state.depthMap)) {
+      depthToBgr(state.depthMap, frame.size(), dst);
+    } else {
+      depthMissing(frame, dst);
+    }
+    break;
+  case '4':
+    if (runDepth(frame, state.depthMap)) {
+      digitalFog(frame, state.depthMap, dst, fogStyle);
+    } else {
+      depthMissing(frame, dst);
+    }
+    break;
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9':
+    if (runTemporal(mode, frame, dst, state) != 0)
+      frame.copyTo(dst);
+    break;
+  default:
+    frame.copyTo(dst);
+    break;
+  }
+  return 0;
+}
+
+// Runs the filter selected by mode on frame, writing a BGR image to dst
+int applyEffect(char mode, cv::Mat &frame, cv::Mat &dst, EffectState &state) {
+  ScopedTimer timer(Stage::Filter);
+  int scale = processingScale(mode);
+  if (scale > 1)
+    return processScaled(
+        frame, dst, scale,
+        [&](cv::Mat &s, cv::Mat &d) { return runEffect(mode, s, d, state); },
+        state.scaled);
+  return runEffect(mode, frame, dst, state);
+}
@@ -6,6 +6,8 @@
   Functions for finding faces and drawing boxes around them
 
   The path to the Haar cascade file is define in faceDetect.h
+  FaceDetector keeps a pool of classifiers so several threads can detect
+  at once; detectFaces uses one shared FaceDetector.
 */
 #include <cmath>
 #include <cstdio>
@@ -14,48 +16,153 @@
 #include "faceDetect.h"
 
 
+FaceDetector::FaceDetector( const FaceDetectorConfig &config ) : config_(config), failed_(false) {
+  if( config_.downscale < 1 )
+    config_.downscale = 1;
+}
+
+std::string FaceDetector::error() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return( error_ );
+}
+
+/*
+  Takes an idle classifier from the pool, loading a new one if every
+  classifier is in use. Returns nullptr if the cascade file cannot be loaded.
+ */
+std::unique_ptr<FaceDetector::Worker> FaceDetector::acquire() {
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    if( failed_ )
+      return( nullptr );
+    if( !idle_.empty() ) {
+      std::unique_ptr<Worker> worker = std::move( idle_.back() );
+      idle_.pop_back();
+      return( worker );
+    }
+  }
+
+  std::unique_ptr<Worker> worker( new Worker() );
+  if( !worker->cascade.load( config_.cascadeFile ) ) {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    failed_ = true;
+    error_ = "Unable to load face cascade file " + config_.cascadeFile;
+    return( nullptr );
+  }
+  return( worker );
+}
+
+void FaceDetector::release( std::unique_ptr<Worker> worker ) {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  idle_.push_back( std::move( worker ) );
+}
+
+bool FaceDetector::load() {
+  std::unique_ptr<Worker> worker = acquire();
+  if( !worker )
+    return( false );
+  release( std::move( worker ) );
+  return( true );
+}
+
 /*
   Arguments:
   cv::Mat grey  - a greyscale source image in which to detect faces
   std::vector<cv::Rect> &faces - a standard vector of cv::Rect rectangles indicating where faces were found
      if the length of the vector is zero, no faces were found
  */
-int detectFaces( cv::Mat &grey, std::vector<cv::Rect> &faces ) {
-  // a static variable to hold a half-size image
-  static cv::Mat half;
-  
-  // a static variable to hold the classifier
-  static cv::CascadeClassifier face_cascade;
-
-  // the path to the haar cascade file
-  static cv::String face_cascade_file(FACE_CASCADE_FILE);
-
-  if( face_cascade.empty() ) {
-    if( !face_cascade.load( face_cascade_file ) ) {
-      printf("Unable to load face cascade file\n");
-      printf("Terminating\n");
-      exit(-1);
-    }
-  }
-
+bool FaceDetector::detect( const cv::Mat &grey, std::vector<cv::Rect> &faces ) {
   // clear the vector of faces
   faces.clear();
-  
-  // cut the image size in half to reduce processing time
-  cv::resize( grey, half, cv::Size(grey.cols/2, grey.rows/2) );
+
+  std::unique_ptr<Worker> worker = acquire();
+  if( !worker )
+    return( false );
+
+  // shrink the image to reduce processing time
+  int d = config_.downscale;
+  cv::resize( grey, worker->small, cv::Size(grey.cols/d, grey.rows/d), 0, 0, cv::INTER_LINEAR );
 
   // equalize the image
-  cv::equalizeHist( half, half );
+  cv::equalizeHist( worker->small, worker->small );
+
+  runCascade( *worker, worker->small, faces );
+  release( std::move( worker ) );
+  return( true );
+}
+
+/*
+  Arguments:
+  cv::Mat small - greyscale image resized by 1/downscale and equalized
+  std::vector<cv::Rect> &faces - faces found, in full size coordinates
+ */
+bool FaceDetector::detectPrepared( const cv::Mat &small, std::vector<cv::Rect> &faces ) {
+  faces.clear();
 
-  // apply the Haar cascade detector
-  face_cascade.detectMultiScale( half, faces );
+  std::unique_ptr<Worker> worker = acquire();
+  if( !worker )
+    return( false );
+
+  runCascade( *worker, small, faces );
+  release( std::move( worker ) );
+  return( true );
+}
+
+/*
+  Runs the Haar cascade on a shrunk, equalized image and scales the
+  rectangles back to the full size image
+ */
+void FaceDetector::runCascade( Worker &worker, const cv::Mat &small, std::vector<cv::Rect> &faces ) {
+  // apply the Haar cascade detector, with the size limits at the small scale
+  int d = config_.downscale;
+  cv::Size minSize( config_.minSize.width/d, config_.minSize.height/d );
+  cv::Size maxSize( config_.maxSize.width/d, config_.maxSize.height/d );
+  worker.cascade.detectMultiScale( small, faces, config_.scaleFactor, config_.minNeighbors, 0, minSize, maxSize );
 
   // adjust the rectangle sizes back to the full size image
   for(int i=0;i<faces.size();i++) {
-    faces[i].x *= 2;
-    faces[i].y *= 2;
-    faces[i].width *= 2;
-    faces[i].height *= 2;
+    faces[i].x *= d;
+    faces[i].y *= d;
+    faces[i].width *= d;
+    faces[i].height *= d;
+  }
+}
+
+/*
+  Runs detect on each image in parallel, faces[i] holds the faces of greys[i]
+ */
+bool FaceDetector::detectBatch( const std::vector<cv::Mat> &greys, std::vector<std::vector<cv::Rect>> &faces ) {
+  faces.resize( greys.size() );
+  std::vector<char> ok( greys.size(), 1 );
+
+  cv::parallel_for_( cv::Range(0, (int)greys.size()), [&](const cv::Range &range) {
+      for(int i=range.start;i<range.end;i++)
+        ok[i] = detect( greys[i], faces[i] );
+    } );
+
+  for(int i=0;i<(int)ok.size();i++) {
+    if( !ok[i] )
+      return( false );
+  }
+  return( true );
+}
+
+/*
+  Detects faces with a detector shared by the whole program, safe to call
+  from several threads. Returns -1 if the cascade file could not be loaded.
+
+  Arguments:
+  cv::Mat grey  - a greyscale source image in which to detect faces
+  std::vector<cv::Rect> &faces - a standard vector of cv::Rect rectangles indicating where faces were found
+     if the length of the vector is zero, no faces were found
+ */
+int detectFaces( cv::Mat &grey, std::vector<cv::Rect> &faces ) {
+  static FaceDetector detector;
+  static std::once_flag reported;
+
+  if( !detector.detect( grey, faces ) ) {
+    std::call_once( reported, [&]() { printf("%s\n", detector.error().c_str()); } );
+    return( -1 );
   }
 
   return(0);
@@ -86,3 +193,24 @@ int drawBoxes( cv::Mat &frame, std::vector<cv::Rect> &faces, int minWidth, float
 
   return(0);
 }
+
+/* Same as drawBoxes, but also writes the tracker id above each box
+
+   Arguments:
+   std::vector<int> &ids - id of each rectangle in faces (same order)
+ */
+int drawBoxes( cv::Mat &frame, std::vector<cv::Rect> &faces, const std::vector<int> &ids, int minWidth, float scale ) {
+  cv::Scalar wcolor(170, 120, 110);
+
+  drawBoxes( frame, faces, minWidth, scale );
+  for(int i=0;i<(int)faces.size() && i<(int)ids.size();i++) {
+    if( faces[i].width > minWidth ) {
+      char label[32];
+      snprintf( label, sizeof(label), "face %d", ids[i] );
+      cv::Point corner( faces[i].x * scale, faces[i].y * scale - 8 );
+      cv::putText( frame, label, corner, cv::FONT_HERSHEY_SIMPLEX, 0.6, wcolor, 2 );
+    }
+  }
+
+  return(0);
+}
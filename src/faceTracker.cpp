@@ -0,0 +1,188 @@
+/**
+ * faceTracker.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Detect-then-track for faces: full detection every few frames, template
+ * matching in between, detection inside a small window when a face is lost.
+ */
+
+#include "../include/faceTracker.h"
+#include <algorithm>
+
+static float overlap(const cv::Rect &a, const cv::Rect &b) {
+  float inter = (float)(a & b).area();
+  float uni = (float)(a.area() + b.area()) - inter;
+  return uni > 0 ? inter / uni : 0;
+}
+
+// box grown by margin * its size on every side, clipped to the frame
+static cv::Rect grow(const cv::Rect &box, float margin, cv::Size frame) {
+  int mx = (int)(box.width * margin), my = (int)(box.height * margin);
+  cv::Rect r(box.x - mx, box.y - my, box.width + 2 * mx, box.height + 2 * my);
+  return r & cv::Rect(0, 0, frame.width, frame.height);
+}
+
+FaceTracker::FaceTracker(const FaceTrackerConfig &config)
+    : config_(config), nextId_(0), sinceDetect_(0), frames_(0),
+      fullDetections_(0), roiDetections_(0) {
+  config_.scale = std::max(1, config_.scale);
+  config_.detectEvery = std::max(1, config_.detectEvery);
+  sinceDetect_ = config_.detectEvery; // detect on the first frame
+}
+
+void FaceTracker::reset() {
+  faces_.clear();
+  sinceDetect_ = config_.detectEvery;
+}
+
+void FaceTracker::setBox(const cv::Mat &grey, TrackedFace &face,
+                         const cv::Rect &box, bool smooth) {
+  cv::Rect b = box;
+  if (smooth) {
+    // pull the new box toward the old one to hide detector jitter
+    float w = config_.smoothing;
+    b.x = cvRound(w * face.box.x + (1 - w) * box.x);
+    b.y = cvRound(w * face.box.y + (1 - w) * box.y);
+    b.width = cvRound(w * face.box.width + (1 - w) * box.width);
+    b.height = cvRound(w * face.box.height + (1 - w) * box.height);
+  }
+  face.box = b & cv::Rect(0, 0, grey.cols, grey.rows);
+  face.score = 1.0f;
+  face.misses = 0;
+
+  int s = config_.scale;
+  cv::Size small(std::max(1, face.box.width / s),
+                 std::max(1, face.box.height / s));
+  if (face.box.area() > 0)
+    cv::resize(grey(face.box), face.templ, small, 0, 0, cv::INTER_AREA);
+}
+
+bool FaceTracker::track(const cv::Mat &grey, TrackedFace &face) {
+  cv::Rect area = grow(face.box, config_.searchMargin, grey.size());
+  int s = config_.scale;
+  cv::Size small(area.width / s, area.height / s);
+  if (face.templ.empty() || small.width < face.templ.cols ||
+      small.height < face.templ.rows)
+    return false;
+
+  cv::resize(grey(area), search_, small, 0, 0, cv::INTER_AREA);
+  cv::matchTemplate(search_, face.templ, score_, cv::TM_CCOEFF_NORMED);
+  double best;
+  cv::Point loc;
+  cv::minMaxLoc(score_, nullptr, &best, nullptr, &loc);
+  face.score = (float)best;
+  if (best < config_.minScore)
+    return false;
+
+  face.box.x = area.x + loc.x * s;
+  face.box.y = area.y + loc.y * s;
+  face.box &= cv::Rect(0, 0, grey.cols, grey.rows);
+  return true;
+}
+
+bool FaceTracker::redetect(cv::Mat &grey, TrackedFace &face,
+                           const FaceDetectFn &detect) {
+  cv::Rect area = grow(face.box, 1.0f, grey.size());
+  if (area.area() == 0)
+    return false;
+  cv::Mat roi = grey(area);
+  detect(roi, found_);
+  roiDetections_++;
+
+  // the detection closest to where the face was
+  cv::Point2f last(face.box.x + face.box.width * 0.5f,
+                   face.box.y + face.box.height * 0.5f);
+  int best = -1;
+  float bestDist = 0;
+  for (size_t i = 0; i < found_.size(); i++) {
+    found_[i].x += area.x;
+    found_[i].y += area.y;
+    float dx = found_[i].x + found_[i].width * 0.5f - last.x;
+    float dy = found_[i].y + found_[i].height * 0.5f - last.y;
+    if (best < 0 || dx * dx + dy * dy < bestDist) {
+      best = (int)i;
+      bestDist = dx * dx + dy * dy;
+    }
+  }
+  if (best < 0)
+    return false;
+  setBox(grey, face, found_[best], true);
+  return true;
+}
+
+void FaceTracker::detectAll(cv::Mat &grey, const FaceDetectFn &detect) {
+  detect(grey, found_);
+  fullDetections_++;
+  sinceDetect_ = 0;
+
+  // greedy matching on overlap keeps ids stable across detections
+  std::vector<bool> used(found_.size(), false);
+  for (size_t k = 0; k < faces_.size(); k++) {
+    TrackedFace &face = faces_[k];
+    int best = -1;
+    float bestOverlap = 0.3f;
+    for (size_t i = 0; i < found_.size(); i++) {
+      float o = overlap(face.box, found_[i]);
+      if (!used[i] && o > bestOverlap) {
+        best = (int)i;
+        bestOverlap = o;
+      }
+    }
+    if (best >= 0) {
+      used[best] = true;
+      setBox(grey, face, found_[best], true);
+    } else if (!missed_[k]) {
+      // one miss per frame, even if update() already counted it
+      face.misses++;
+    }
+  }
+
+  for (size_t i = 0; i < found_.size(); i++) {
+    if (used[i])
+      continue;
+    TrackedFace face;
+    face.id = nextId_++;
+    setBox(grey, face, found_[i], false);
+    faces_.push_back(face);
+  }
+}
+
+const std::vector<TrackedFace> &
+FaceTracker::update(cv::Mat &grey, const FaceDetectFn &detect) {
+  frames_++;
+  sinceDetect_++;
+
+  bool lost = false;
+  missed_.assign(faces_.size(), 0);
+  for (size_t k = 0; k < faces_.size(); k++) {
+    TrackedFace &face = faces_[k];
+    if (track(grey, face))
+      continue;
+    if (!redetect(grey, face, detect)) {
+      face.misses++;
+      missed_[k] = 1;
+      lost = true;
+    }
+  }
+
+  // a face we could not find anywhere near its box may have jumped
+  if (lost || sinceDetect_ >= config_.detectEvery)
+    detectAll(grey, detect);
+
+  faces_.erase(std::remove_if(faces_.begin(), faces_.end(),
+                              [&](const TrackedFace &f) {
+                                return f.misses > config_.maxMisses ||
+                                       f.box.area() == 0;
+                              }),
+               faces_.end());
+  return faces_;
+}
+
+void FaceTracker::boxes(std::vector<cv::Rect> &faces,
+                        std::vector<int> &ids) const {
+  faces.clear();
+  ids.clear();
+  for (const auto &face : faces_) {
+    faces.push_back(face.box);
+    ids.push_back(face.id);
+  }
+}
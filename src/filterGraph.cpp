@@ -0,0 +1,200 @@
+/**
+ * filterGraph.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Filter graph construction and per-frame evaluation.
+ */
+
+#include "../include/filterGraph.h"
+#include "../include/filters.h"
+#include <cstdlib>
+#include <iostream>
+
+cv::Mat &FrameArena::acquire(cv::Size size, int type) {
+  for (auto &s : slots_) {
+    if (!s.used && s.mat.size() == size && s.mat.type() == type) {
+      s.used = true;
+      return s.mat;
+    }
+  }
+  // no exact match: recycle any free buffer before growing the pool
+  Slot *slot = nullptr;
+  for (auto &s : slots_) {
+    if (!s.used) {
+      slot = &s;
+      break;
+    }
+  }
+  if (slot == nullptr) {
+    slots_.emplace_back();
+    slot = &slots_.back();
+  }
+  slot->mat.create(size, type);
+  slot->used = true;
+  allocations_++;
+  return slot->mat;
+}
+
+void FrameArena::reset() {
+  for (auto &s : slots_)
+    s.used = false;
+}
+
+FilterGraph::FilterGraph() { clear(); }
+
+void FilterGraph::clear() {
+  nodes_.clear();
+  index_.clear();
+  nodes_.push_back({SOURCE, -1, -1, 0, &source_});
+  output_ = 0;
+}
+
+int FilterGraph::addNode(Op op, int in0, int in1, int param) {
+  auto key = std::make_tuple((int)op, in0, in1, param);
+  auto it = index_.find(key);
+  if (it != index_.end())
+    return it->second;
+
+  nodes_.push_back({op, in0, in1, param, nullptr});
+  int id = (int)nodes_.size() - 1;
+  index_[key] = id;
+  return id;
+}
+
+int FilterGraph::addEffect(const std::string &spec, int in) {
+  // optional ":param", e.g. "cartoon:6"
+  std::string name = spec;
+  int param = 10;
+  size_t colon = spec.find(':');
+  if (colon != std::string::npos) {
+    name = spec.substr(0, colon);
+    param = std::atoi(spec.c_str() + colon + 1);
+    if (param < 1)
+      return -1;
+  }
+  // quantize buckets are 255 / levels wide, so more levels would be 0
+  if ((name == "quantize" || name == "cartoon") && param > 255)
+    return -1;
+
+  if (name == "grey")
+    return addNode(GREY, in);
+  if (name == "sepia")
+    return addNode(SEPIA, in);
+  if (name == "blur")
+    return addNode(BLUR, in);
+  if (name == "quantize")
+    return addNode(QUANTIZE, addNode(BLUR, in), -1, param);
+  if (name == "edges")
+    return addNode(MAGNITUDE, in);
+  if (name == "neon")
+    return addNode(NEON, in, addNode(EDGES, in));
+  if (name == "smooth")
+    return addNode(SMOOTH, in, -1, colon != std::string::npos ? param : 20);
+  if (name == "cartoon") {
+    // quantize and edges share one smoothing of the input
+    int smooth = addNode(SMOOTH, in, -1, 20);
+    return addNode(CARTOON, addNode(QUANTIZE, smooth, -1, param),
+                   addNode(EDGES, smooth));
+  }
+  if (name == "painterly") {
+    int smooth = addNode(SMOOTH, in, -1, 40);
+    return addNode(PAINTERLY, smooth, addNode(EDGES, smooth));
+  }
+  if (name == "depth")
+    return addNode(DEPTH_BGR, addNode(DEPTH, in));
+  if (name == "fog")
+    return addNode(FOG, in, addNode(DEPTH, in));
+  return -1;
+}
+
+int FilterGraph::addChain(const std::string &spec, int input) {
+  int node = input;
+  size_t start = 0;
+  while (start <= spec.size()) {
+    size_t end = spec.find('>', start);
+    if (end == std::string::npos)
+      end = spec.size();
+    std::string name = spec.substr(start, end - start);
+    node = addEffect(name, node);
+    if (node < 0) {
+      std::cerr << "Unknown effect in chain: '" << name << "'" << std::endl;
+      return -1;
+    }
+    start = end + 1;
+  }
+  output_ = node;
+  return node;
+}
+
+void FilterGraph::eval(Node &n, cv::Mat &out) {
+  cv::Mat &a = *nodes_[n.in0].out;
+  switch (n.op) {
+  case SOURCE:
+    break;
+  case GREY:
+    greyscale(a, out);
+    break;
+  case SEPIA:
+    sepia(a, out);
+    break;
+  case BLUR:
+    blur5x5_3(a, out);
+    break;
+  case QUANTIZE:
+    quantize(a, out, n.param);
+    break;
+  case EDGES:
+    sobelEdges3x3(a, out);
+    break;
+  case MAGNITUDE:
+    sobelMagnitude3x3(a, out);
+    break;
+  case NEON:
+    neonCompose(a, *nodes_[n.in1].out, out);
+    break;
+  case CARTOON:
+    cartoonCompose(a, *nodes_[n.in1].out, out);
+    break;
+  case SMOOTH:
+    domainTransform(a, out, (float)n.param);
+    break;
+  case PAINTERLY:
+    painterlyCompose(a, *nodes_[n.in1].out, out);
+    break;
+  case DEPTH:
+    // no model: zero depth, which leaves fog transparent
+    if (!depthFn_ || !depthFn_(a, out)) {
+      out.create(a.size(), CV_8UC1);
+      out.setTo(0);
+    }
+    break;
+  case DEPTH_BGR:
+    depthToBgr(a, source_.size(), out);
+    break;
+  case FOG:
+    digitalFog(a, *nodes_[n.in1].out, out, fog_);
+    break;
+  }
+}
+
+int FilterGraph::run(cv::Mat &src, cv::Mat &dst) {
+  arena_.reset();
+  source_ = src; // header only, no copy
+  nodes_[0].out = &source_;
+
+  for (size_t i = 1; i < nodes_.size(); i++) {
+    Node &n = nodes_[i];
+    if ((int)i == output_) {
+      n.out = &dst;
+    } else if (n.op == DEPTH) {
+      n.out = &n.own; // sized by the depth model, not the frame
+    } else {
+      int type = n.op == EDGES ? CV_8UC1 : CV_8UC3;
+      n.out = &arena_.acquire(src.size(), type);
+    }
+    eval(n, *n.out);
+  }
+
+  if (output_ == 0)
+    src.copyTo(dst);
+  return 0;
+}
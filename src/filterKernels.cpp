@@ -0,0 +1,99 @@
+/**
+ * filterKernels.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Row kernels of greyscale, sepia, the fused Sobel filters, fog and the
+ * domain transform.
+ *
+ * This file is compiled once per instruction set with KERNEL_ISA set to
+ * baseline, avx2 or avx512 and the matching -m flags, so the compiler
+ * vectorizes the same plain loops for each. Nothing here may come from a
+ * header with inline functions (OpenCV, <algorithm>...): the linker keeps
+ * one copy of those, which could be the AVX-512 one on a CPU without it.
+ */
+
+#include "../include/filterKernels.h"
+
+#ifndef KERNEL_ISA
+#define KERNEL_ISA baseline
+#endif
+
+#define KERNEL_STR2(x) #x
+#define KERNEL_STR(x) KERNEL_STR2(x)
+#define KERNEL_CAT2(a, b) a##_##b
+#define KERNEL_CAT(a, b) KERNEL_CAT2(a, b)
+
+static inline int maxOf(int a, int b) { return a > b ? a : b; }
+static inline int minOf(int a, int b) { return a < b ? a : b; }
+
+static void greyRow(const uint8_t *s, uint8_t *d, int cols) {
+  for (int j = 0; j < cols; j++) {
+    int b = s[3 * j], g = s[3 * j + 1], r = s[3 * j + 2];
+    d[j] = (uint8_t)((maxOf(b, maxOf(g, r)) + minOf(b, minOf(g, r))) / 2);
+  }
+}
+
+// Same fixed point as before the split: sepia matrix * 4096, the sums
+// shifted down 4 before the vignette multiply so they fit 32 bits
+static void sepiaRow(const uint8_t *s, uint8_t *d, int cols, const int *col,
+                     int rowTerm) {
+  for (int j = 0; j < cols; j++) {
+    int b = s[3 * j], g = s[3 * j + 1], r = s[3 * j + 2];
+    int v = col[j] - rowTerm;
+    int db = ((537 * b + 2187 * g + 1114 * r) >> 4) * v;
+    int dg = ((688 * b + 2810 * g + 1430 * r) >> 4) * v;
+    int dr = ((774 * b + 3150 * g + 1610 * r) >> 4) * v;
+    d[3 * j] = (uint8_t)minOf(255, (db + (1 << 19)) >> 20);
+    d[3 * j + 1] = (uint8_t)minOf(255, (dg + (1 << 19)) >> 20);
+    d[3 * j + 2] = (uint8_t)minOf(255, (dr + (1 << 19)) >> 20);
+  }
+}
+
+// Rounded sqrt(gx^2 + gy^2) capped at 255. The square root of an integer
+// is never within float precision of x.5 here, so adding 0.5 rounds like
+// cvRound does.
+static inline int gradMag(const uint8_t *up, const uint8_t *mid,
+                          const uint8_t *dn, int x) {
+  int gx = (up[x + 3] - up[x - 3]) + 2 * (mid[x + 3] - mid[x - 3]) +
+           (dn[x + 3] - dn[x - 3]);
+  int gy = (up[x - 3] + 2 * up[x] + up[x + 3]) -
+           (dn[x - 3] + 2 * dn[x] + dn[x + 3]);
+  float m = __builtin_sqrtf((float)(gx * gx + gy * gy));
+  return minOf(255, (int)(m + 0.5f));
+}
+
+static void sobelMagRow(const uint8_t *up, const uint8_t *mid,
+                        const uint8_t *dn, uint8_t *d, int cols) {
+  for (int x = 3; x < (cols - 1) * 3; x++)
+    d[x] = (uint8_t)gradMag(up, mid, dn, x);
+}
+
+static void sobelEdgesRow(const uint8_t *up, const uint8_t *mid,
+                          const uint8_t *dn, uint8_t *d, int cols) {
+  for (int j = 1; j < cols - 1; j++) {
+    int x = j * 3;
+    d[j] = (uint8_t)((gradMag(up, mid, dn, x) + gradMag(up, mid, dn, x + 1) +
+                      gradMag(up, mid, dn, x + 2)) /
+                     3);
+  }
+}
+
+static void fogRow(const uint8_t *s, uint8_t *d, int cols,
+                   const uint16_t *keep, const uint16_t *add) {
+  for (int j = 0; j < cols; j++) {
+    int k = keep[j];
+    d[3 * j] = (uint8_t)((s[3 * j] * k + add[3 * j]) >> 8);
+    d[3 * j + 1] = (uint8_t)((s[3 * j + 1] * k + add[3 * j + 1]) >> 8);
+    d[3 * j + 2] = (uint8_t)((s[3 * j + 2] * k + add[3 * j + 2]) >> 8);
+  }
+}
+
+static void recursiveRow(float *__restrict cur, const float *__restrict prev,
+                         const float *__restrict weight, int n) {
+  for (int k = 0; k < n; k++)
+    cur[k] += weight[k] * (prev[k] - cur[k]);
+}
+
+extern const FilterKernels KERNEL_CAT(filterKernels, KERNEL_ISA);
+const FilterKernels KERNEL_CAT(filterKernels, KERNEL_ISA) = {
+    KERNEL_STR(KERNEL_ISA), greyRow, sepiaRow, sobelMagRow, sobelEdgesRow,
+    fogRow, recursiveRow};
@@ -2,68 +2,95 @@
  * filters.cpp
  * Shivang Patel (shivang2402) - 2026-01-23
  * Image filter implementations.
+ *
+ * Every filter runs its row loop through parallelRows, so each band writes
+ * its own rows; filters that read neighbouring rows rebuild that halo.
+ * The hottest row loops live in filterKernels.cpp, built per instruction
+ * set and picked at runtime.
  */
 
 #include "../include/filters.h"
+#include "../include/filterKernels.h"
+#include "../include/parallel.h"
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 // Greyscale using desaturation: (max + min) / 2
 int greyscale(cv::Mat &src, cv::Mat &dst) {
   dst.create(src.size(), src.type());
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < src.cols; j++) {
-      uchar maxVal = std::max({srcRow[j][0], srcRow[j][1], srcRow[j][2]});
-      uchar minVal = std::min({srcRow[j][0], srcRow[j][1], srcRow[j][2]});
-      uchar grey = (maxVal + minVal) / 2;
-      dstRow[j] = cv::Vec3b(grey, grey, grey);
+  parallelRows(src.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
+      cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
+      for (int j = 0; j < src.cols; j++) {
+        uchar maxVal = std::max({srcRow[j][0], srcRow[j][1], srcRow[j][2]});
+        uchar minVal = std::min({srcRow[j][0], srcRow[j][1], srcRow[j][2]});
+        uchar grey = (maxVal + minVal) / 2;
+        dstRow[j] = cv::Vec3b(grey, grey, grey);
+      }
     }
-  }
+  });
+  return 0;
+}
+
+// Same desaturation into a single-channel image, a third of the writes
+int greyscalePlane(cv::Mat &src, cv::Mat &dst) {
+  dst.create(src.size(), CV_8UC1);
+  parallelRows(src.rows, [&](int r0, int r1) {
+    const FilterKernels &k = filterKernels();
+    for (int i = r0; i < r1; i++)
+      k.greyRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), src.cols);
+  });
   return 0;
 }
 
-// Sepia tone transformation
+// Vignette 1 - 0.3 * (dx^2 + dy^2), with dx, dy in [-1, 1] from the centre.
+// It is a sum of a column term and a row term, so only those are kept,
+// in 12-bit fixed point, once per frame size.
+struct VignetteLut {
+  std::vector<int> col, row;
+};
+
+static const VignetteLut &vignetteLut(int rows, int cols) {
+  static std::mutex mutex;
+  static std::map<std::pair<int, int>, std::unique_ptr<VignetteLut>> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<VignetteLut> &lut = cache[std::make_pair(rows, cols)];
+  if (!lut) {
+    lut.reset(new VignetteLut());
+    lut->col.resize(cols);
+    lut->row.resize(rows);
+    for (int j = 0; j < cols; j++) {
+      double dx = (j - cols / 2.0) / (cols / 2.0);
+      lut->col[j] = (int)std::lround(4096 * (1.0 - 0.3 * dx * dx));
+    }
+    for (int i = 0; i < rows; i++) {
+      double dy = (i - rows / 2.0) / (rows / 2.0);
+      lut->row[i] = (int)std::lround(4096 * 0.3 * dy * dy);
+    }
+  }
+  return *lut;
+}
+
+// Sepia tone transformation with a vignette (0.4 at the corners).
+// Integer only: the sepia matrix is in 12-bit fixed point and the channel
+// sums are scaled by the cached vignette before the final shift.
 int sepia(cv::Mat &src, cv::Mat &dst) {
   dst.create(src.size(), src.type());
-  // Calculate center of image
   int rows = src.rows;
   int cols = src.cols;
+  const VignetteLut &vig = vignetteLut(rows, cols);
 
-  for (int i = 0; i < rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < cols; j++) {
-      float b = srcRow[j][0], g = srcRow[j][1], r = srcRow[j][2];
-
-      // Calculate vignetting (darken as we get further from center)
-      // distance from center normalized to [0, 1] range roughly
-      // (1 - dist) used as scaling factor
-      // Simple approximation:
-      // 1.0 at center, fading to ~0.4 at corners
-
-      // Sepia transform
-      float db = 0.272f * r + 0.534f * g + 0.131f * b;
-      float dg = 0.349f * r + 0.686f * g + 0.168f * b;
-      float dr = 0.393f * r + 0.769f * g + 0.189f * b;
-
-      // Apply vignette
-      // Using a simpler cosine-based or distance-based falloff
-      // Or just a simple manual falloff to match report claims
-      // Let's implement a quick nice vignette:
-      double dx = (j - cols / 2.0) / (cols / 2.0); // -1 to 1
-      double dy = (i - rows / 2.0) / (rows / 2.0); // -1 to 1
-      double distSq = dx * dx + dy * dy;
-      double vignette = 1.0 - (distSq * 0.3); // 0.3 strength
-      if (vignette < 0)
-        vignette = 0;
-
-      dstRow[j][0] = cv::saturate_cast<uchar>(db * vignette);
-      dstRow[j][1] = cv::saturate_cast<uchar>(dg * vignette);
-      dstRow[j][2] = cv::saturate_cast<uchar>(dr * vignette);
-    }
-  }
+  parallelRows(rows, [&](int r0, int r1) {
+    const FilterKernels &k = filterKernels();
+    for (int i = r0; i < r1; i++)
+      k.sepiaRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), cols, vig.col.data(),
+                 vig.row[i]);
+  });
   return 0;
 }
 
@@ -76,159 +103,223 @@ int blur5x5_1(cv::Mat &src, cv::Mat &dst) {
                       {2, 4, 8, 4, 2},
                       {1, 2, 4, 2, 1}};
 
-  for (int i = 2; i < src.rows - 2; i++) {
-    for (int j = 2; j < src.cols - 2; j++) {
-      int sumB = 0, sumG = 0, sumR = 0;
-      for (int ki = -2; ki <= 2; ki++) {
-        for (int kj = -2; kj <= 2; kj++) {
-          cv::Vec3b px = src.at<cv::Vec3b>(i + ki, j + kj);
-          int w = kernel[ki + 2][kj + 2];
-          sumB += px[0] * w;
-          sumG += px[1] * w;
-          sumR += px[2] * w;
+  // src is only read and dst rows are split between bands
+  parallelRows(src.rows, [&](int r0, int r1) {
+    for (int i = std::max(r0, 2); i < std::min(r1, src.rows - 2); i++) {
+      for (int j = 2; j < src.cols - 2; j++) {
+        int sumB = 0, sumG = 0, sumR = 0;
+        for (int ki = -2; ki <= 2; ki++) {
+          for (int kj = -2; kj <= 2; kj++) {
+            cv::Vec3b px = src.at<cv::Vec3b>(i + ki, j + kj);
+            int w = kernel[ki + 2][kj + 2];
+            sumB += px[0] * w;
+            sumG += px[1] * w;
+            sumR += px[2] * w;
+          }
         }
+        dst.at<cv::Vec3b>(i, j) =
+            cv::Vec3b(sumB / 100, sumG / 100, sumR / 100);
       }
-      dst.at<cv::Vec3b>(i, j) = cv::Vec3b(sumB / 100, sumG / 100, sumR / 100);
     }
-  }
+  });
   return 0;
 }
 
 // Optimized separable 5x5 blur using row pointers
 int blur5x5_2(cv::Mat &src, cv::Mat &dst) {
-  cv::Mat temp;
-  src.copyTo(temp);
-  src.copyTo(dst);
+  // bands read src rows owned by their neighbours, so never blur in place
+  cv::Mat in = (src.data == dst.data) ? src.clone() : src;
+  dst.create(in.size(), in.type());
   int k[5] = {1, 2, 4, 2, 1};
+  int rows = in.rows, cols = in.cols;
 
-  // Horizontal pass
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    cv::Vec3b *tempRow = temp.ptr<cv::Vec3b>(i);
-    for (int j = 2; j < src.cols - 2; j++) {
-      int sB = 0, sG = 0, sR = 0;
-      for (int x = -2; x <= 2; x++) {
-        sB += srcRow[j + x][0] * k[x + 2];
-        sG += srcRow[j + x][1] * k[x + 2];
-        sR += srcRow[j + x][2] * k[x + 2];
+  parallelRows(rows, [&](int r0, int r1) {
+    // Horizontal pass over the band plus a 2-row halo on each side
+    int t0 = std::max(r0 - 2, 0), t1 = std::min(r1 + 2, rows);
+    cv::Mat temp = in.rowRange(t0, t1).clone();
+    for (int i = t0; i < t1; i++) {
+      cv::Vec3b *srcRow = in.ptr<cv::Vec3b>(i);
+      cv::Vec3b *tempRow = temp.ptr<cv::Vec3b>(i - t0);
+      for (int j = 2; j < cols - 2; j++) {
+        int sB = 0, sG = 0, sR = 0;
+        for (int x = -2; x <= 2; x++) {
+          sB += srcRow[j + x][0] * k[x + 2];
+          sG += srcRow[j + x][1] * k[x + 2];
+          sR += srcRow[j + x][2] * k[x + 2];
+        }
+        tempRow[j] = cv::Vec3b(sB / 10, sG / 10, sR / 10);
       }
-      tempRow[j] = cv::Vec3b(sB / 10, sG / 10, sR / 10);
     }
-  }
 
-  // Vertical pass
-  for (int i = 2; i < src.rows - 2; i++) {
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < src.cols; j++) {
-      int sB = 0, sG = 0, sR = 0;
-      for (int y = -2; y <= 2; y++) {
-        cv::Vec3b *tRow = temp.ptr<cv::Vec3b>(i + y);
-        sB += tRow[j][0] * k[y + 2];
-        sG += tRow[j][1] * k[y + 2];
-        sR += tRow[j][2] * k[y + 2];
+    // Vertical pass, the top and bottom 2 rows keep the source
+    for (int i = r0; i < r1; i++) {
+      cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
+      if (i < 2 || i >= rows - 2) {
+        std::copy(in.ptr<cv::Vec3b>(i), in.ptr<cv::Vec3b>(i) + cols, dstRow);
+        continue;
+      }
+      for (int j = 0; j < cols; j++) {
+        int sB = 0, sG = 0, sR = 0;
+        for (int y = -2; y <= 2; y++) {
+          cv::Vec3b *tRow = temp.ptr<cv::Vec3b>(i + y - t0);
+          sB += tRow[j][0] * k[y + 2];
+          sG += tRow[j][1] * k[y + 2];
+          sR += tRow[j][2] * k[y + 2];
+        }
+        dstRow[j] = cv::Vec3b(sB / 10, sG / 10, sR / 10);
       }
-      dstRow[j] = cv::Vec3b(sB / 10, sG / 10, sR / 10);
     }
-  }
+  });
   return 0;
 }
 
-// Sobel X (positive right): [-1 0 1] * [1 2 1]^T
-int sobelX3x3(cv::Mat &src, cv::Mat &dst) {
-  cv::Mat temp(src.size(), CV_16SC3, cv::Scalar(0));
+// Separable 3x3 kernel into CV_16SC3, shared by the two Sobel filters.
+// Border rows and columns are left at 0.
+static void sobel3x3(cv::Mat &src, cv::Mat &dst, const int hK[3],
+                     const int vK[3]) {
   dst.create(src.size(), CV_16SC3);
-  dst.setTo(0);
+  int rows = src.rows, cols = src.cols;
 
-  int hK[3] = {-1, 0, 1}, vK[3] = {1, 2, 1};
-
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    cv::Vec3s *tempRow = temp.ptr<cv::Vec3s>(i);
-    for (int j = 1; j < src.cols - 1; j++) {
-      for (int c = 0; c < 3; c++) {
-        tempRow[j][c] = srcRow[j - 1][c] * hK[0] + srcRow[j][c] * hK[1] +
-                        srcRow[j + 1][c] * hK[2];
+  parallelRows(rows, [&](int r0, int r1) {
+    // Horizontal pass over the band plus a 1-row halo on each side
+    int t0 = std::max(r0 - 1, 0), t1 = std::min(r1 + 1, rows);
+    cv::Mat temp(t1 - t0, cols, CV_16SC3, cv::Scalar(0));
+    for (int i = t0; i < t1; i++) {
+      cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
+      cv::Vec3s *tempRow = temp.ptr<cv::Vec3s>(i - t0);
+      for (int j = 1; j < cols - 1; j++) {
+        for (int c = 0; c < 3; c++) {
+          tempRow[j][c] = srcRow[j - 1][c] * hK[0] + srcRow[j][c] * hK[1] +
+                          srcRow[j + 1][c] * hK[2];
+        }
       }
     }
-  }
 
-  for (int i = 1; i < src.rows - 1; i++) {
-    cv::Vec3s *dstRow = dst.ptr<cv::Vec3s>(i);
-    for (int j = 0; j < src.cols; j++) {
-      for (int c = 0; c < 3; c++) {
-        dstRow[j][c] = temp.ptr<cv::Vec3s>(i - 1)[j][c] * vK[0] +
-                       temp.ptr<cv::Vec3s>(i)[j][c] * vK[1] +
-                       temp.ptr<cv::Vec3s>(i + 1)[j][c] * vK[2];
+    for (int i = r0; i < r1; i++) {
+      cv::Vec3s *dstRow = dst.ptr<cv::Vec3s>(i);
+      if (i < 1 || i >= rows - 1) {
+        std::fill(dstRow, dstRow + cols, cv::Vec3s(0, 0, 0));
+        continue;
+      }
+      for (int j = 0; j < cols; j++) {
+        for (int c = 0; c < 3; c++) {
+          dstRow[j][c] = temp.ptr<cv::Vec3s>(i - 1 - t0)[j][c] * vK[0] +
+                         temp.ptr<cv::Vec3s>(i - t0)[j][c] * vK[1] +
+                         temp.ptr<cv::Vec3s>(i + 1 - t0)[j][c] * vK[2];
+        }
       }
     }
-  }
+  });
+}
+
+// Sobel X (positive right): [-1 0 1] * [1 2 1]^T
+int sobelX3x3(cv::Mat &src, cv::Mat &dst) {
+  int hK[3] = {-1, 0, 1}, vK[3] = {1, 2, 1};
+  sobel3x3(src, dst, hK, vK);
   return 0;
 }
 
 // Sobel Y (positive up): [1 2 1] * [1 0 -1]^T
 int sobelY3x3(cv::Mat &src, cv::Mat &dst) {
-  cv::Mat temp(src.size(), CV_16SC3, cv::Scalar(0));
-  dst.create(src.size(), CV_16SC3);
-  dst.setTo(0);
-
   int hK[3] = {1, 2, 1}, vK[3] = {1, 0, -1};
+  sobel3x3(src, dst, hK, vK);
+  return 0;
+}
 
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    cv::Vec3s *tempRow = temp.ptr<cv::Vec3s>(i);
-    for (int j = 1; j < src.cols - 1; j++) {
-      for (int c = 0; c < 3; c++) {
-        tempRow[j][c] = srcRow[j - 1][c] * hK[0] + srcRow[j][c] * hK[1] +
-                        srcRow[j + 1][c] * hK[2];
+// Gradient magnitude: sqrt(sx^2 + sy^2)
+int magnitude(cv::Mat &sx, cv::Mat &sy, cv::Mat &dst) {
+  dst.create(sx.size(), CV_8UC3);
+  parallelRows(sx.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      cv::Vec3s *sxRow = sx.ptr<cv::Vec3s>(i);
+      cv::Vec3s *syRow = sy.ptr<cv::Vec3s>(i);
+      cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
+      for (int j = 0; j < sx.cols; j++) {
+        for (int c = 0; c < 3; c++) {
+          float gx = sxRow[j][c], gy = syRow[j][c];
+          dstRow[j][c] =
+              cv::saturate_cast<uchar>(std::sqrt(gx * gx + gy * gy));
+        }
       }
     }
-  }
+  });
+  return 0;
+}
 
-  for (int i = 1; i < src.rows - 1; i++) {
-    cv::Vec3s *dstRow = dst.ptr<cv::Vec3s>(i);
-    for (int j = 0; j < src.cols; j++) {
-      for (int c = 0; c < 3; c++) {
-        dstRow[j][c] = temp.ptr<cv::Vec3s>(i - 1)[j][c] * vK[0] +
-                       temp.ptr<cv::Vec3s>(i)[j][c] * vK[1] +
-                       temp.ptr<cv::Vec3s>(i + 1)[j][c] * vK[2];
+// Fused sobelX3x3 + sobelY3x3 + magnitude, no 16-bit intermediates.
+// Same output as the three-call version, border pixels are 0.
+int sobelMagnitude3x3(cv::Mat &src, cv::Mat &dst) {
+  dst.create(src.size(), CV_8UC3);
+  int rows = src.rows, cols = src.cols;
+  parallelRows(rows, [&](int r0, int r1) {
+    const FilterKernels &k = filterKernels();
+    for (int i = r0; i < r1; i++) {
+      uchar *d = dst.ptr<uchar>(i);
+      if (i < 1 || i >= rows - 1 || cols < 3) {
+        std::fill(d, d + cols * 3, 0);
+        continue;
       }
+      const uchar *up = src.ptr<uchar>(i - 1);
+      const uchar *mid = src.ptr<uchar>(i);
+      const uchar *dn = src.ptr<uchar>(i + 1);
+      k.sobelMagRow(up, mid, dn, d, cols);
+      std::fill(d, d + 3, 0);
+      std::fill(d + (cols - 1) * 3, d + cols * 3, 0);
     }
-  }
+  });
   return 0;
 }
 
-// Gradient magnitude: sqrt(sx^2 + sy^2)
-int magnitude(cv::Mat &sx, cv::Mat &sy, cv::Mat &dst) {
-  dst.create(sx.size(), CV_8UC3);
-  for (int i = 0; i < sx.rows; i++) {
-    cv::Vec3s *sxRow = sx.ptr<cv::Vec3s>(i);
-    cv::Vec3s *syRow = sy.ptr<cv::Vec3s>(i);
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < sx.cols; j++) {
-      for (int c = 0; c < 3; c++) {
-        float gx = sxRow[j][c], gy = syRow[j][c];
-        dstRow[j][c] = cv::saturate_cast<uchar>(std::sqrt(gx * gx + gy * gy));
+// Channel-averaged edge strength (CV_8UC1), the value neonEdges and cartoon
+// threshold: (mag[0] + mag[1] + mag[2]) / 3
+int sobelEdges3x3(cv::Mat &src, cv::Mat &dst) {
+  dst.create(src.size(), CV_8UC1);
+  int rows = src.rows, cols = src.cols;
+  parallelRows(rows, [&](int r0, int r1) {
+    const FilterKernels &k = filterKernels();
+    for (int i = r0; i < r1; i++) {
+      uchar *d = dst.ptr<uchar>(i);
+      if (i < 1 || i >= rows - 1 || cols < 3) {
+        std::fill(d, d + cols, 0);
+        continue;
       }
+      const uchar *up = src.ptr<uchar>(i - 1);
+      const uchar *mid = src.ptr<uchar>(i);
+      const uchar *dn = src.ptr<uchar>(i + 1);
+      d[0] = d[cols - 1] = 0;
+      k.sobelEdgesRow(up, mid, dn, d, cols);
     }
-  }
+  });
   return 0;
 }
 
-// Blur then quantize into N levels
-int blurQuantize(cv::Mat &src, cv::Mat &dst, int levels) {
-  blur5x5_2(src, dst);
-  int bucket = 255 / levels;
-  for (int i = 0; i < dst.rows; i++) {
-    cv::Vec3b *row = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < dst.cols; j++) {
-      for (int c = 0; c < 3; c++) {
-        row[j][c] = (row[j][c] / bucket) * bucket;
-      }
+// Quantize into N levels (src may be dst). The bucket of every byte value
+// comes from a 256-entry table, so there is no divide per channel.
+int quantize(cv::Mat &src, cv::Mat &dst, int levels) {
+  dst.create(src.size(), src.type());
+  int bucket = std::max(1, 255 / std::max(1, levels));
+  uchar lut[256];
+  for (int v = 0; v < 256; v++)
+    lut[v] = (uchar)((v / bucket) * bucket);
+
+  int n = src.cols * src.channels();
+  parallelRows(src.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uchar *s = src.ptr<uchar>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int j = 0; j < n; j++)
+        d[j] = lut[s[j]];
     }
-  }
+  });
   return 0;
 }
 
+// Blur then quantize into N levels
+int blurQuantize(cv::Mat &src, cv::Mat &dst, int levels) {
+  blur5x5_3(src, dst);
+  return quantize(dst, dst, levels);
+}
+
 // Spotlight: greyscale except for face regions
 int spotlight(cv::Mat &src, cv::Mat &dst, std::vector<cv::Rect> &faces) {
   greyscale(src, dst);
@@ -247,66 +338,207 @@ int spotlight(cv::Mat &src, cv::Mat &dst, std::vector<cv::Rect> &faces) {
 
 // Neon edges: bright edges on dark background
 int neonEdges(cv::Mat &src, cv::Mat &dst) {
-  cv::Mat sobelX, sobelY, mag;
-  sobelX3x3(src, sobelX);
-  sobelY3x3(src, sobelY);
-  magnitude(sobelX, sobelY, mag);
+  cv::Mat edges;
+  sobelEdges3x3(src, edges);
+  return neonCompose(src, edges, dst);
+}
 
+// Neon colouring of src given its sobelEdges3x3 strength
+int neonCompose(cv::Mat &src, cv::Mat &edges, cv::Mat &dst) {
   dst.create(src.size(), src.type());
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    cv::Vec3b *magRow = mag.ptr<cv::Vec3b>(i);
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < src.cols; j++) {
-      int edge = (magRow[j][0] + magRow[j][1] + magRow[j][2]) / 3;
-      if (edge > 30) {
-        dstRow[j][0] = cv::saturate_cast<uchar>(srcRow[j][0] * 0.3 + 180);
-        dstRow[j][1] = cv::saturate_cast<uchar>(srcRow[j][1] * 0.5 + 200);
-        dstRow[j][2] = cv::saturate_cast<uchar>(srcRow[j][2] * 0.3 + 50);
-      } else {
-        dstRow[j] =
-            cv::Vec3b(srcRow[j][0] / 8, srcRow[j][1] / 8, srcRow[j][2] / 8);
+  parallelRows(src.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
+      uchar *edgeRow = edges.ptr<uchar>(i);
+      cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
+      for (int j = 0; j < src.cols; j++) {
+        if (edgeRow[j] > 30) {
+          dstRow[j][0] = cv::saturate_cast<uchar>(srcRow[j][0] * 0.3 + 180);
+          dstRow[j][1] = cv::saturate_cast<uchar>(srcRow[j][1] * 0.5 + 200);
+          dstRow[j][2] = cv::saturate_cast<uchar>(srcRow[j][2] * 0.3 + 50);
+        } else {
+          dstRow[j] =
+              cv::Vec3b(srcRow[j][0] / 8, srcRow[j][1] / 8, srcRow[j][2] / 8);
+        }
       }
     }
-  }
+  });
   return 0;
 }
 
-// Cartoon: quantized colors with black edge outlines
+// Cartoon: edge-preserving smoothing quantized into N levels, with black
+// outlines where the smoothed image has edges (so texture and noise inside
+// a region draw no lines)
 int cartoon(cv::Mat &src, cv::Mat &dst, int levels) {
-  cv::Mat quantized, sobelX, sobelY, mag;
-  blurQuantize(src, quantized, levels);
-  sobelX3x3(src, sobelX);
-  sobelY3x3(src, sobelY);
-  magnitude(sobelX, sobelY, mag);
+  cv::Mat smooth, edges;
+  domainTransform(src, smooth);
+  sobelEdges3x3(smooth, edges);
+  quantize(smooth, smooth, levels);
+  return cartoonCompose(smooth, edges, dst);
+}
 
-  dst.create(src.size(), src.type());
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *qRow = quantized.ptr<cv::Vec3b>(i);
-    cv::Vec3b *mRow = mag.ptr<cv::Vec3b>(i);
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < src.cols; j++) {
-      int edge = (mRow[j][0] + mRow[j][1] + mRow[j][2]) / 3;
-      dstRow[j] = (edge > 40) ? cv::Vec3b(0, 0, 0) : qRow[j];
+// Painterly: wider smoothing, colours lifted away from grey by a quarter,
+// and soft dark strokes along edges, as dark as the edge is strong
+int painterly(cv::Mat &src, cv::Mat &dst) {
+  cv::Mat smooth, edges;
+  domainTransform(src, smooth, 40.0f);
+  sobelEdges3x3(smooth, edges);
+  return painterlyCompose(smooth, edges, dst);
+}
+
+// Black outlines where edges is strong, quantized colour elsewhere
+int cartoonCompose(cv::Mat &quantized, cv::Mat &edges, cv::Mat &dst) {
+  dst.create(quantized.size(), quantized.type());
+  parallelRows(quantized.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      cv::Vec3b *qRow = quantized.ptr<cv::Vec3b>(i);
+      uchar *edgeRow = edges.ptr<uchar>(i);
+      cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
+      for (int j = 0; j < quantized.cols; j++) {
+        dstRow[j] = (edgeRow[j] > 40) ? cv::Vec3b(0, 0, 0) : qRow[j];
+      }
     }
-  }
+  });
   return 0;
 }
 
-// Digital fog: exponential fog based on depth
-int digitalFog(cv::Mat &src, cv::Mat &depthMap, cv::Mat &dst) {
+// Saturation lift and edge strokes of painterly
+int painterlyCompose(cv::Mat &smooth, cv::Mat &edges, cv::Mat &dst) {
+  dst.create(smooth.size(), CV_8UC3);
+  parallelRows(smooth.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uchar *s = smooth.ptr<uchar>(i);
+      const uchar *e = edges.ptr<uchar>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int j = 0; j < smooth.cols; j++, s += 3, d += 3) {
+        int mean = (s[0] + s[1] + s[2]) * 85 >> 8; // / 3
+        int shade = 256 - std::min((int)e[j], 160); // strokes up to 5/8
+        for (int c = 0; c < 3; c++) {
+          int v = mean + (s[c] - mean) * 5 / 4;
+          v = std::min(255, std::max(0, v));
+          d[c] = (uchar)(v * shade >> 8);
+        }
+      }
+    }
+  });
+  return 0;
+}
+
+// fog = 1 - exp(-density * depth / 255) only has 256 values per style:
+// out = src * (1 - fog) + colour * fog is kept as (src * keep[d] + add) >> 8
+struct FogLut {
+  uint16_t keep[256], add[256][3];
+};
+
+static const FogLut &fogLut(const FogStyle &style) {
+  static std::mutex mutex;
+  static std::map<std::pair<float, int>, std::unique_ptr<FogLut>> cache;
+  const cv::Vec3b &c = style.colour;
+  int packed = c[0] | c[1] << 8 | c[2] << 16;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<FogLut> &lut =
+      cache[std::make_pair(style.density, packed)];
+  if (!lut) {
+    lut.reset(new FogLut());
+    for (int d = 0; d < 256; d++) {
+      float fog = 1.0f - std::exp(-d / 255.0f * style.density);
+      lut->keep[d] = (uint16_t)std::lround(256 * (1 - fog));
+      for (int k = 0; k < 3; k++) // + 128 rounds the final shift
+        lut->add[d][k] = (uint16_t)(std::lround(256 * c[k] * fog) + 128);
+    }
+  }
+  return *lut;
+}
+
+// Bilinear taps from dstLen samples onto srcLen, with pixel centres lined
+// up as cv::resize does; weights of i1 in 1/256
+struct LinearTaps {
+  std::vector<int> i0, i1, w;
+};
+
+static const LinearTaps &linearTaps(int dstLen, int srcLen) {
+  static std::mutex mutex;
+  static std::map<std::pair<int, int>, std::unique_ptr<LinearTaps>> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<LinearTaps> &taps = cache[std::make_pair(dstLen, srcLen)];
+  if (!taps) {
+    taps.reset(new LinearTaps());
+    taps->i0.resize(dstLen);
+    taps->i1.resize(dstLen);
+    taps->w.resize(dstLen);
+    double ratio = (double)srcLen / dstLen;
+    for (int j = 0; j < dstLen; j++) {
+      double x = std::max(0.0, (j + 0.5) * ratio - 0.5);
+      int x0 = std::min((int)x, srcLen - 1);
+      taps->i0[j] = x0;
+      taps->i1[j] = std::min(x0 + 1, srcLen - 1);
+      taps->w[j] = (int)std::lround((x - x0) * 256);
+    }
+  }
+  return *taps;
+}
+
+// Digital fog: exponential fog based on depth. A depth map smaller than
+// src (the model's own output size) is sampled bilinearly row by row, so
+// the full-size map never exists; each row is then one LUT lookup per
+// pixel and the 8.8 blend kernel.
+int digitalFog(cv::Mat &src, cv::Mat &depthMap, cv::Mat &dst,
+               const FogStyle &style) {
+  if (depthMap.empty() || depthMap.type() != CV_8UC1)
+    return -1;
+  const FogLut &lut = fogLut(style);
+  int rows = src.rows, cols = src.cols;
+  bool scaled = depthMap.size() != src.size();
+  const LinearTaps *tx = scaled ? &linearTaps(cols, depthMap.cols) : nullptr;
+  const LinearTaps *ty = scaled ? &linearTaps(rows, depthMap.rows) : nullptr;
+
   dst.create(src.size(), src.type());
-  for (int i = 0; i < src.rows; i++) {
-    cv::Vec3b *srcRow = src.ptr<cv::Vec3b>(i);
-    uchar *depthRow = depthMap.ptr<uchar>(i);
-    cv::Vec3b *dstRow = dst.ptr<cv::Vec3b>(i);
-    for (int j = 0; j < src.cols; j++) {
-      float fog = 1.0f - std::exp(-depthRow[j] / 255.0f * 3.0f);
-      for (int c = 0; c < 3; c++) {
-        dstRow[j][c] =
-            cv::saturate_cast<uchar>(srcRow[j][c] * (1 - fog) + 255 * fog);
+  parallelRows(rows, [&](int r0, int r1) {
+    const FilterKernels &k = filterKernels();
+    std::vector<uint16_t> keep(cols), add(cols * 3);
+    // depth * 256 after the vertical taps, then the sampled row
+    std::vector<int> column(scaled ? depthMap.cols : 0);
+    std::vector<uchar> sampled(scaled ? cols : 0);
+    for (int i = r0; i < r1; i++) {
+      const uchar *depth;
+      if (!scaled) {
+        depth = depthMap.ptr<uchar>(i);
+      } else {
+        const uchar *a = depthMap.ptr<uchar>(ty->i0[i]);
+        const uchar *b = depthMap.ptr<uchar>(ty->i1[i]);
+        int wb = ty->w[i], wa = 256 - wb;
+        for (int x = 0; x < depthMap.cols; x++)
+          column[x] = a[x] * wa + b[x] * wb;
+        for (int j = 0; j < cols; j++) {
+          int w = tx->w[j];
+          sampled[j] = (uchar)((column[tx->i0[j]] * (256 - w) +
+                                column[tx->i1[j]] * w + (1 << 15)) >>
+                               16);
+        }
+        depth = sampled.data();
+      }
+      for (int j = 0; j < cols; j++) {
+        const uint16_t *a = lut.add[depth[j]];
+        keep[j] = lut.keep[depth[j]];
+        add[3 * j] = a[0];
+        add[3 * j + 1] = a[1];
+        add[3 * j + 2] = a[2];
       }
+      k.fogRow(src.ptr<uchar>(i), dst.ptr<uchar>(i), cols, keep.data(),
+               add.data());
     }
+  });
+  return 0;
+}
+
+// Depth map as a BGR image of size; maps at the model's size are scaled up
+int depthToBgr(cv::Mat &depth, cv::Size size, cv::Mat &dst) {
+  if (depth.size() == size) {
+    cv::cvtColor(depth, dst, cv::COLOR_GRAY2BGR);
+    return 0;
   }
+  thread_local cv::Mat full;
+  cv::resize(depth, full, size);
+  cv::cvtColor(full, dst, cv::COLOR_GRAY2BGR);
   return 0;
 }
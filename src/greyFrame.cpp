@@ -0,0 +1,45 @@
+/**
+ * greyFrame.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Lazily computed grey, half-size and equalized copies of a frame.
+ */
+
+#include "../include/greyFrame.h"
+#include <algorithm>
+
+void GreyFrame::reset(const cv::Mat &frame) {
+  frame_ = frame;
+  haveGrey_ = false;
+  smallD_ = equalizedD_ = 0;
+}
+
+const cv::Mat &GreyFrame::grey() {
+  // never alias grey_ to the frame: the next cvtColor would write into it
+  if (frame_.channels() == 1)
+    return frame_;
+  if (!haveGrey_) {
+    cv::cvtColor(frame_, grey_, cv::COLOR_BGR2GRAY);
+    haveGrey_ = true;
+  }
+  return grey_;
+}
+
+const cv::Mat &GreyFrame::small(int d) {
+  d = std::max(1, d);
+  if (smallD_ != d) {
+    const cv::Mat &g = grey();
+    cv::resize(g, small_, cv::Size(g.cols / d, g.rows / d), 0, 0,
+               cv::INTER_LINEAR);
+    smallD_ = d;
+  }
+  return small_;
+}
+
+const cv::Mat &GreyFrame::equalized(int d) {
+  d = std::max(1, d);
+  if (equalizedD_ != d) {
+    cv::equalizeHist(small(d), equalized_);
+    equalizedD_ = d;
+  }
+  return equalized_;
+}
@@ -0,0 +1,58 @@
+/**
+ * kernelDispatch.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Picks the filterKernels build for this CPU.
+ *
+ * The build defines FILTER_KERNELS_X86 when it also compiled the AVX2 and
+ * AVX-512 copies of filterKernels.cpp; otherwise only the baseline exists.
+ */
+
+#include "../include/filterKernels.h"
+#include <cstring>
+
+extern const FilterKernels filterKernels_baseline;
+#ifdef FILTER_KERNELS_X86
+extern const FilterKernels filterKernels_avx2;
+extern const FilterKernels filterKernels_avx512;
+
+static bool hasAvx512() {
+  return __builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512bw") &&
+         __builtin_cpu_supports("avx512vl");
+}
+#endif
+
+static const FilterKernels *bestKernels() {
+#ifdef FILTER_KERNELS_X86
+  if (hasAvx512())
+    return &filterKernels_avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return &filterKernels_avx2;
+#endif
+  return &filterKernels_baseline;
+}
+
+static const FilterKernels *&currentKernels() {
+  static const FilterKernels *kernels = bestKernels();
+  return kernels;
+}
+
+const FilterKernels &filterKernels() { return *currentKernels(); }
+
+bool setFilterKernels(const char *name) {
+  if (std::strcmp(name, "baseline") == 0) {
+    currentKernels() = &filterKernels_baseline;
+    return true;
+  }
+#ifdef FILTER_KERNELS_X86
+  if (std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+    currentKernels() = &filterKernels_avx2;
+    return true;
+  }
+  if (std::strcmp(name, "avx512") == 0 && hasAvx512()) {
+    currentKernels() = &filterKernels_avx512;
+    return true;
+  }
+#endif
+  return false;
+}
@@ -0,0 +1,47 @@
+/**
+ * parallel.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Row bands on top of cv::parallel_for_.
+ */
+
+#include "../include/parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <opencv2/opencv.hpp>
+
+// Bands shorter than this cost more in halo rows and scheduling than they win
+static const int MIN_BAND_ROWS = 16;
+
+static std::atomic<int> filterThreads(0);
+
+void setFilterThreads(int n) {
+  filterThreads.store(std::max(0, n));
+  // cv::parallel_for_ runs on OpenCV's pool, so size that pool too
+  cv::setNumThreads(n > 0 ? n : -1);
+}
+
+int getFilterThreads() {
+  int n = filterThreads.load();
+  return n > 0 ? n : cv::getNumberOfCPUs();
+}
+
+void parallelRows(int rows, const std::function<void(int, int)> &body) {
+  if (rows <= 0)
+    return;
+  int bands = std::min(getFilterThreads(), rows / MIN_BAND_ROWS);
+  if (bands <= 1) {
+    body(0, rows);
+    return;
+  }
+
+  cv::parallel_for_(
+      cv::Range(0, bands),
+      [&](const cv::Range &r) {
+        for (int b = r.start; b < r.end; b++) {
+          int r0 = (int)((long)rows * b / bands);
+          int r1 = (int)((long)rows * (b + 1) / bands);
+          body(r0, r1);
+        }
+      },
+      bands);
+}
@@ -0,0 +1,233 @@
+/**
+ * pipeline.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Capture thread, filter workers and in-order delivery to the display.
+ */
+
+#include "../include/pipeline.h"
+#include "../include/stageTimer.h"
+#include <chrono>
+#include <sstream>
+
+// Spin briefly, then sleep, while waiting on another stage
+static void backoff(int &spins) {
+  if (++spins < 64)
+    std::this_thread::yield();
+  else
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+FramePipeline::FramePipeline(const PipelineConfig &cfg)
+    : cfg_(cfg), running_(false), captureDone_(false), workersDone_(0),
+      mode_('c'), dropped_(0), nextSeq_(0), captureRec_(nullptr),
+      captureFps_(0) {
+  if (cfg_.workers < 1)
+    cfg_.workers = 1;
+  for (int i = 0; i < cfg_.workers; i++) {
+    in_.emplace_back(new Ring(cfg_.queueDepth));
+    out_.emplace_back(new Ring(cfg_.queueDepth));
+  }
+  states_.resize(cfg_.workers);
+}
+
+FramePipeline::~FramePipeline() { stop(); }
+
+bool FramePipeline::start(cv::VideoCapture &cap, char mode) {
+  if (!cap.isOpened())
+    return false;
+  cv::Size size((int)cap.get(cv::CAP_PROP_FRAME_WIDTH),
+                (int)cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+  cv::VideoCapture *c = &cap;
+  return startWith(
+      [c](cv::Mat &frame) {
+        *c >> frame;
+        return !frame.empty();
+      },
+      size, true, mode);
+}
+
+bool FramePipeline::start(RawReplay &replay, cv::Size size, char mode) {
+  RawReplay *r = &replay;
+  return startWith([r](cv::Mat &frame) { return r->next(frame); }, size,
+                   false, mode);
+}
+
+bool FramePipeline::startWith(Grab grab, cv::Size size, bool allocInput,
+                              char mode) {
+  if (!threads_.empty())
+    return false;
+
+  // Preallocate every slot at the capture size so steady state never
+  // reallocates (filters that keep size and type write in place). Replay
+  // puts views of the file in the input slots, so only outputs need it.
+  if (size.width > 0 && size.height > 0) {
+    auto alloc = [&](FrameSlot &s) { s.frame.create(size, CV_8UC3); };
+    for (int i = 0; i < cfg_.workers; i++) {
+      if (allocInput)
+        in_[i]->forEachSlot(alloc);
+      out_[i]->forEachSlot(alloc);
+    }
+  }
+
+  mode_.store(mode);
+  running_.store(true);
+  threads_.emplace_back(&FramePipeline::captureLoop, this, grab);
+  for (int i = 0; i < cfg_.workers; i++)
+    threads_.emplace_back(&FramePipeline::workerLoop, this, i);
+  return true;
+}
+
+void FramePipeline::stop() {
+  running_.store(false);
+  for (auto &t : threads_)
+    t.join();
+  threads_.clear();
+}
+
+void FramePipeline::captureLoop(Grab grab) {
+  cv::Mat scratch;
+  long seq = 0;
+
+  while (running()) {
+    Ring &ring = *in_[seq % cfg_.workers];
+    FrameSlot *slot = ring.writeSlot();
+    int spins = 0;
+    while (!slot && cfg_.policy == QueuePolicy::Block && running()) {
+      backoff(spins);
+      slot = ring.writeSlot();
+    }
+    if (!running())
+      break;
+
+    // With no free slot the camera is still drained so the next frame is
+    // fresh; the frame itself is dropped
+    cv::Mat &target = slot ? slot->frame : scratch;
+    bool got;
+    {
+      ScopedTimer timer(Stage::Capture);
+      got = grab(target);
+    }
+    if (!got)
+      break;
+    if (captureRec_)
+      captureRec_->addFrame(target, captureFps_ > 0
+                                        ? (int64_t)(seq * 1e6 / captureFps_)
+                                        : -1);
+
+    if (slot) {
+      slot->seq = seq;
+      slot->mode = mode_.load();
+      ring.commitWrite();
+    } else {
+      dropped_++;
+    }
+    seq++;
+  }
+  captureDone_.store(true);
+}
+
+void FramePipeline::workerLoop(int id) {
+  Ring &in = *in_[id];
+  Ring &out = *out_[id];
+  EffectState &state = states_[id];
+  int spins = 0;
+
+  while (running()) {
+    FrameSlot *src = in.readSlot();
+    if (!src) {
+      if (captureDone_.load() && in.empty())
+        break;
+      backoff(spins);
+      continue;
+    }
+    spins = 0;
+
+    if (cfg_.policy == QueuePolicy::DropOldest) {
+      // skip ahead to the newest queued frame
+      while (in.size() > 1) {
+        in.commitRead();
+        dropped_++;
+      }
+      src = in.readSlot();
+    }
+
+    FrameSlot *dst = out.writeSlot();
+    while (!dst && cfg_.policy == QueuePolicy::Block && running()) {
+      backoff(spins);
+      dst = out.writeSlot();
+    }
+    spins = 0;
+
+    if (dst) {
+      applyEffect(src->mode, src->frame, dst->frame, state);
+      dst->seq = src->seq;
+      dst->mode = src->mode;
+      out.commitWrite();
+    } else if (running()) {
+      dropped_++;
+    }
+    in.commitRead();
+  }
+  workersDone_++;
+}
+
+bool FramePipeline::next(cv::Mat &displayFrame) {
+  int spins = 0;
+
+  while (running()) {
+    Ring *ring = nullptr;
+    FrameSlot *slot = nullptr;
+
+    if (cfg_.policy == QueuePolicy::Block) {
+      // nothing is dropped, so frame nextSeq_ is always on this worker
+      ring = out_[nextSeq_ % cfg_.workers].get();
+      slot = ring->readSlot();
+    } else {
+      // take the oldest finished frame; anything older than a frame
+      // already shown arrived late and is discarded to keep the order
+      for (auto &r : out_) {
+        FrameSlot *s = r->readSlot();
+        while (s && s->seq < nextSeq_) {
+          r->commitRead();
+          dropped_++;
+          s = r->readSlot();
+        }
+        if (s && (!slot || s->seq < slot->seq)) {
+          ring = r.get();
+          slot = s;
+        }
+      }
+    }
+
+    if (slot) {
+      // swap instead of copy: the slot keeps the old display buffer
+      cv::swap(slot->frame, displayFrame);
+      nextSeq_ = slot->seq + 1;
+      ring->commitRead();
+      return true;
+    }
+
+    if (workersDone_.load() == cfg_.workers) {
+      bool drained = true;
+      for (auto &r : out_)
+        drained = drained && r->empty();
+      if (drained)
+        return false;
+      continue;
+    }
+    backoff(spins);
+  }
+  return false;
+}
+
+std::string FramePipeline::queueDepths() const {
+  std::ostringstream ss;
+  ss << "capture->filter [";
+  for (int i = 0; i < cfg_.workers; i++)
+    ss << (i ? " " : "") << in_[i]->size();
+  ss << "] filter->display [";
+  for (int i = 0; i < cfg_.workers; i++)
+    ss << (i ? " " : "") << out_[i]->size();
+  ss << "] dropped " << dropped();
+  return ss.str();
+}
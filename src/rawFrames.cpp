@@ -0,0 +1,216 @@
+/**
+ * rawFrames.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Writing, mapping and paced replay of .vraw frame files.
+ */
+
+#include "../include/rawFrames.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static const char RAW_MAGIC[8] = {'V', 'F', 'X', 'R', 'A', 'W', 0, 0};
+static const uint32_t RAW_VERSION = 1;
+static const uint32_t RAW_DATA_OFFSET = 4096;
+static const uint32_t RAW_RECORD_HEADER = 64;
+static const uint32_t RAW_MAX_SIDE = 1 << 16; // far above 8K, fits an int
+
+// What each record starts with, padded to RAW_RECORD_HEADER bytes
+struct RawRecordHeader {
+  int64_t timestampUs;
+  int64_t seq;
+};
+
+// only 8-bit BGR and grey frames are stored
+static uint32_t pixelBytes(int type) { return type == CV_8UC3 ? 3 : 1; }
+
+bool isRawFramePath(const std::string &path) {
+  return path.size() > 5 && path.compare(path.size() - 5, 5, ".vraw") == 0;
+}
+
+RawFrameWriter::RawFrameWriter() : file_(nullptr) {
+  std::memset(&header_, 0, sizeof(header_));
+}
+
+RawFrameWriter::~RawFrameWriter() { close(); }
+
+bool RawFrameWriter::open(const std::string &path, cv::Size size, int type,
+                          double fps) {
+  close();
+  if (type != CV_8UC3 && type != CV_8UC1)
+    return false;
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_)
+    return false;
+  // large writes; the default stdio buffer would split every row
+  std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+  std::memset(&header_, 0, sizeof(header_));
+  std::memcpy(header_.magic, RAW_MAGIC, sizeof(RAW_MAGIC));
+  header_.version = RAW_VERSION;
+  header_.type = (uint32_t)type;
+  header_.width = (uint32_t)size.width;
+  header_.height = (uint32_t)size.height;
+  uint32_t rowBytes = size.width * pixelBytes(type);
+  header_.stride = (rowBytes + 63) / 64 * 64;
+  header_.dataOffset = RAW_DATA_OFFSET;
+  header_.recordBytes =
+      RAW_RECORD_HEADER + (uint64_t)header_.stride * header_.height;
+  header_.fps = fps;
+  padding_.assign(std::max<size_t>(RAW_DATA_OFFSET, header_.stride), 0);
+
+  std::memcpy(padding_.data(), &header_, sizeof(header_));
+  if (std::fwrite(padding_.data(), 1, RAW_DATA_OFFSET, file_) !=
+      RAW_DATA_OFFSET) {
+    close();
+    return false;
+  }
+  std::fill(padding_.begin(), padding_.end(), 0);
+  return true;
+}
+
+bool RawFrameWriter::write(const cv::Mat &frame, int64_t timestampUs) {
+  if (!file_ || frame.type() != (int)header_.type ||
+      frame.cols != (int)header_.width || frame.rows != (int)header_.height)
+    return false;
+
+  uchar head[RAW_RECORD_HEADER] = {0};
+  RawRecordHeader rec = {timestampUs, (int64_t)header_.frameCount};
+  std::memcpy(head, &rec, sizeof(rec));
+  bool ok = std::fwrite(head, 1, sizeof(head), file_) == sizeof(head);
+
+  size_t rowBytes = frame.cols * frame.elemSize();
+  size_t pad = header_.stride - rowBytes;
+  for (int i = 0; ok && i < frame.rows; i++) {
+    ok = std::fwrite(frame.ptr(i), 1, rowBytes, file_) == rowBytes;
+    if (ok && pad > 0)
+      ok = std::fwrite(padding_.data(), 1, pad, file_) == pad;
+  }
+  if (ok)
+    header_.frameCount++;
+  return ok;
+}
+
+void RawFrameWriter::close() {
+  if (!file_)
+    return;
+  std::fseek(file_, 0, SEEK_SET);
+  std::fwrite(&header_, 1, sizeof(header_), file_);
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+RawFrameReader::RawFrameReader() : base_(nullptr), length_(0), frames_(0) {
+  std::memset(&header_, 0, sizeof(header_));
+}
+
+RawFrameReader::~RawFrameReader() { close(); }
+
+bool RawFrameReader::open(const std::string &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  bool ok = fstat(fd, &st) == 0 && st.st_size >= (off_t)RAW_DATA_OFFSET &&
+            ::read(fd, &header_, sizeof(header_)) == sizeof(header_);
+  ok = ok && std::memcmp(header_.magic, RAW_MAGIC, sizeof(RAW_MAGIC)) == 0 &&
+       header_.version == RAW_VERSION &&
+       (header_.type == CV_8UC3 || header_.type == CV_8UC1) &&
+       header_.width > 0 && header_.height > 0 &&
+       header_.width <= RAW_MAX_SIDE && header_.height <= RAW_MAX_SIDE &&
+       header_.stride >=
+           (uint64_t)header_.width * pixelBytes(header_.type) &&
+       header_.recordBytes ==
+           RAW_RECORD_HEADER + (uint64_t)header_.stride * header_.height &&
+       header_.dataOffset >= sizeof(RawFileHeader) &&
+       header_.dataOffset % 64 == 0 &&
+       (off_t)header_.dataOffset <= st.st_size;
+  if (!ok) {
+    ::close(fd);
+    std::cerr << "Not a raw frame file: " << path << std::endl;
+    return false;
+  }
+
+  length_ = (size_t)st.st_size;
+  void *p =
+      mmap(nullptr, length_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file
+  if (p == MAP_FAILED) {
+    length_ = 0;
+    return false;
+  }
+  base_ = (uchar *)p;
+  madvise(base_, length_, MADV_SEQUENTIAL);
+
+  // a recording that was cut off has count 0 or a partial last record
+  long whole = (long)((length_ - header_.dataOffset) / header_.recordBytes);
+  frames_ = header_.frameCount > 0
+                ? std::min(whole, (long)header_.frameCount)
+                : whole;
+  return true;
+}
+
+void RawFrameReader::close() {
+  if (base_)
+    munmap(base_, length_);
+  base_ = nullptr;
+  length_ = 0;
+  frames_ = 0;
+}
+
+cv::Mat RawFrameReader::frame(long n) const {
+  if (!base_ || n < 0 || n >= frames_)
+    return cv::Mat();
+  return cv::Mat((int)header_.height, (int)header_.width, (int)header_.type,
+                 record(n) + RAW_RECORD_HEADER, header_.stride);
+}
+
+int64_t RawFrameReader::timestampUs(long n) const {
+  if (!base_ || n < 0 || n >= frames_)
+    return 0;
+  RawRecordHeader rec;
+  std::memcpy(&rec, record(n), sizeof(rec));
+  return rec.timestampUs;
+}
+
+RawReplay::RawReplay(const RawFrameReader &file, double speed, bool loop)
+    : file_(file), speed_(speed), loop_(loop), next_(0), offsetUs_(0) {}
+
+bool RawReplay::next(cv::Mat &frame) {
+  long n = file_.frames();
+  if (n == 0)
+    return false;
+  if (next_ >= n) {
+    if (!loop_)
+      return false;
+    // continue the clock one frame after the last one
+    double fps = file_.fps() > 0 ? file_.fps() : 30;
+    offsetUs_ += file_.timestampUs(n - 1) - file_.timestampUs(0) +
+                 (int64_t)(1e6 / fps);
+    next_ = 0;
+  }
+
+  if (speed_ > 0) {
+    int64_t t = file_.timestampUs(next_) - file_.timestampUs(0) + offsetUs_;
+    if (next_ == 0 && offsetUs_ == 0)
+      start_ = std::chrono::steady_clock::now();
+    typedef std::chrono::steady_clock Clock;
+    std::this_thread::sleep_until(
+        start_ + std::chrono::duration_cast<Clock::duration>(
+                     std::chrono::duration<double, std::micro>(t / speed_)));
+  }
+  // the filters take BGR, so grey recordings (e.g. vid -m g --record) are
+  // expanded into frame's own buffer; BGR ones stay views of the file
+  cv::Mat view = file_.frame(next_++);
+  if (view.type() == CV_8UC1)
+    cv::cvtColor(view, frame, cv::COLOR_GRAY2BGR);
+  else
+    frame = view;
+  return true;
+}
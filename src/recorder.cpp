@@ -0,0 +1,209 @@
+/**
+ * recorder.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Writer thread for continuous recording (encoded or .vraw) and snapshots.
+ */
+
+#include "../include/recorder.h"
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+Recorder::Recorder(const RecorderConfig &cfg)
+    : cfg_(cfg), ring_(std::max(1, cfg.queueDepth)), running_(false),
+      recording_(false), segment_(0), counter_(0), openSegment_(0),
+      written_(0), dropped_(0), snapshots_(0), failed_(0) {}
+
+Recorder::~Recorder() { stop(); }
+
+bool Recorder::start() {
+  if (thread_.joinable())
+    return false;
+  running_.store(true);
+  thread_ = std::thread(&Recorder::writerLoop, this);
+  return true;
+}
+
+void Recorder::stop() {
+  recording_.store(false);
+  running_.store(false);
+  if (thread_.joinable())
+    thread_.join();
+}
+
+std::string Recorder::nextPath(const char *prefix, const std::string &ext) {
+  return std::string("../data/") + prefix + "_" +
+         std::to_string(std::time(nullptr)) + "_" +
+         std::to_string(counter_++) + "." + ext;
+}
+
+void Recorder::setRecording(bool on) {
+  if (on == recording_.load())
+    return;
+  if (on) {
+    segmentPath_ = cfg_.path;
+    if (segmentPath_.empty()) {
+      segmentPath_ = nextPath("recording", cfg_.container);
+    } else if (segment_ > 0) {
+      // a fixed path gets _2, _3... for later recordings
+      size_t dot = segmentPath_.rfind('.');
+      if (dot == std::string::npos || dot < segmentPath_.rfind('/') + 1)
+        dot = segmentPath_.size();
+      segmentPath_.insert(dot, "_" + std::to_string(segment_ + 1));
+    }
+    segment_++;
+    std::cout << "Recording: " << segmentPath_ << std::endl;
+  }
+  recording_.store(on);
+}
+
+bool Recorder::push(const cv::Mat &frame, const std::string &snapshot,
+                    int64_t timestampUs) {
+  Slot *slot = ring_.writeSlot();
+  while (!slot && !cfg_.dropWhenFull && running_.load()) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    slot = ring_.writeSlot();
+  }
+  if (!slot) {
+    dropped_++;
+    return false;
+  }
+  // slots keep their buffer, so after the first frames this is a memcpy
+  frame.copyTo(slot->frame);
+  // assigning keeps each string's capacity, so no allocation per frame
+  slot->segment = segment_;
+  slot->videoPath = segmentPath_;
+  slot->snapshot = snapshot;
+  slot->timestampUs = timestampUs;
+  slot->queued = std::chrono::steady_clock::now();
+  ring_.commitWrite();
+  return true;
+}
+
+bool Recorder::addFrame(const cv::Mat &frame, int64_t timestampUs) {
+  return recording_.load() && push(frame, "", timestampUs);
+}
+
+std::string Recorder::snapshot(const cv::Mat &frame) {
+  std::string path = nextPath("screenshot", cfg_.snapshotFormat);
+  return push(frame, path, -1) ? path : "";
+}
+
+bool Recorder::openVideo(Slot &slot) {
+  writer_.release();
+  raw_.close();
+  openSegment_ = slot.segment;
+  const std::string &path = slot.videoPath;
+  double fps = cfg_.fps > 0 ? cfg_.fps : 30;
+  if (isRawFramePath(path)) {
+    rawStart_ = slot.queued;
+    if (raw_.open(path, slot.frame.size(), slot.frame.type(), fps))
+      return true;
+  } else {
+    const char *c = cfg_.fourcc.c_str();
+    writer_.open(path, cv::VideoWriter::fourcc(c[0], c[1], c[2], c[3]), fps,
+                 slot.frame.size());
+    if (writer_.isOpened()) {
+      writer_.set(cv::VIDEOWRITER_PROP_QUALITY, cfg_.quality);
+      return true;
+    }
+  }
+  std::cerr << "Unable to open recording: " << path << std::endl;
+  return false;
+}
+
+void Recorder::writeVideo(Slot &slot) {
+  if (slot.segment != openSegment_)
+    openVideo(slot);
+  if (!writer_.isOpened() && !raw_.isOpened()) {
+    failed_++;
+    return;
+  }
+  ScopedTimer timer(Stage::Encode);
+  if (raw_.isOpened()) {
+    // the file keeps the type of its first frame
+    const cv::Mat *frame = &slot.frame;
+    if (slot.frame.type() != raw_.type()) {
+      cv::cvtColor(slot.frame, bgr_,
+                   raw_.type() == CV_8UC1 ? cv::COLOR_BGR2GRAY
+                                          : cv::COLOR_GRAY2BGR);
+      frame = &bgr_;
+    }
+    int64_t us = slot.timestampUs;
+    if (us < 0)
+      us = std::chrono::duration_cast<std::chrono::microseconds>(
+               slot.queued - rawStart_)
+               .count();
+    if (!raw_.write(*frame, us)) {
+      failed_++;
+      return;
+    }
+  } else if (slot.frame.channels() == 1) {
+    // grey modes are queued as one channel and expanded here, off the
+    // display thread
+    cv::cvtColor(slot.frame, bgr_, cv::COLOR_GRAY2BGR);
+    writer_.write(bgr_);
+  } else {
+    writer_.write(slot.frame);
+  }
+  written_++;
+}
+
+void Recorder::writeSnapshot(Slot &slot) {
+  std::vector<int> params;
+  if (cfg_.snapshotFormat == "jpg")
+    params = {cv::IMWRITE_JPEG_QUALITY, cfg_.quality};
+  else if (cfg_.snapshotFormat == "png")
+    params = {cv::IMWRITE_PNG_COMPRESSION, 1}; // fast, still lossless
+  if (cv::imwrite(slot.snapshot, slot.frame, params)) {
+    snapshots_++;
+    std::cout << "Saved: " << slot.snapshot << std::endl;
+  } else {
+    failed_++;
+    std::cerr << "Unable to save " << slot.snapshot << std::endl;
+  }
+}
+
+void Recorder::writerLoop() {
+  for (;;) {
+    Slot *slot = ring_.readSlot();
+    if (!slot) {
+      if (!running_.load())
+        break;
+      // recording stopped and everything queued is written: close the file
+      if (!recording_.load() && (writer_.isOpened() || raw_.isOpened())) {
+        writer_.release();
+        raw_.close();
+        openSegment_ = 0;
+        std::cout << stats() << std::endl;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+
+    if (slot->snapshot.empty())
+      writeVideo(*slot);
+    else
+      writeSnapshot(*slot);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - slot->queued)
+                  .count();
+    latency_.record((uint64_t)us);
+    ring_.commitRead();
+  }
+  writer_.release();
+  raw_.close();
+}
+
+std::string Recorder::stats() const {
+  char line[256];
+  snprintf(line, sizeof(line),
+           "Recorder: %ld frames written, %ld dropped (queue full), "
+           "%ld snapshots, %ld failed, queue to disk p50 %.1f ms, "
+           "p99 %.1f ms",
+           written_.load(), dropped_.load(), snapshots_.load(),
+           failed_.load(), latency_.percentile(0.5) / 1000.0,
+           latency_.percentile(0.99) / 1000.0);
+  return line;
+}
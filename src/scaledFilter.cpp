@@ -0,0 +1,110 @@
+/**
+ * scaledFilter.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Reduced-resolution filtering with joint bilateral upsampling.
+ */
+
+#include "../include/scaledFilter.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Low-res neighbours and the 8-bit weight of the second one, for every
+// full-res coordinate along one axis (pixel centres aligned)
+static void upsampleTaps(int full, int low, std::vector<int> &i0,
+                         std::vector<int> &i1, std::vector<int> &w1) {
+  i0.resize(full);
+  i1.resize(full);
+  w1.resize(full);
+  double ratio = (double)low / full;
+  for (int x = 0; x < full; x++) {
+    double f = (x + 0.5) * ratio - 0.5;
+    int a = (int)std::floor(f);
+    int w = (int)std::lround((f - a) * 256);
+    if (a < 0) {
+      a = 0;
+      w = 0;
+    }
+    i0[x] = std::min(a, low - 1);
+    i1[x] = std::min(a + 1, low - 1);
+    w1[x] = w;
+  }
+}
+
+int jointBilateralUpsample(cv::Mat &lowGuide, cv::Mat &lowDst,
+                           cv::Mat &guide, cv::Mat &dst, float sigma) {
+  if (lowGuide.size() != lowDst.size() || lowDst.type() != CV_8UC3 ||
+      guide.type() != CV_8UC3)
+    return -1;
+  dst.create(guide.size(), CV_8UC3);
+
+  std::vector<int> x0, x1, wx, y0, y1, wy;
+  upsampleTaps(guide.cols, lowGuide.cols, x0, x1, wx);
+  upsampleTaps(guide.rows, lowGuide.rows, y0, y1, wy);
+
+  // range weight by the sum of absolute channel differences, in 8 bits;
+  // never 0, so a pixel unlike all four neighbours still gets their mean
+  int range[3 * 255 + 1];
+  for (int d = 0; d <= 3 * 255; d++) {
+    double m = d / 3.0;
+    double w = 256 * std::exp(-m * m / (2.0 * sigma * sigma));
+    range[d] = std::max(1, (int)std::lround(w));
+  }
+
+  parallelRows(guide.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uchar *g = guide.ptr<uchar>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      const uchar *lg[2] = {lowGuide.ptr<uchar>(y0[i]),
+                            lowGuide.ptr<uchar>(y1[i])};
+      const uchar *lo[2] = {lowDst.ptr<uchar>(y0[i]),
+                            lowDst.ptr<uchar>(y1[i])};
+      int wRow[2] = {256 - wy[i], wy[i]};
+
+      for (int j = 0; j < guide.cols; j++, g += 3, d += 3) {
+        int cx[2] = {x0[j] * 3, x1[j] * 3};
+        int wCol[2] = {256 - wx[j], wx[j]};
+        int sum = 0, acc0 = 0, acc1 = 0, acc2 = 0;
+        for (int a = 0; a < 2; a++) {
+          for (int b = 0; b < 2; b++) {
+            const uchar *q = lg[a] + cx[b];
+            int diff =
+                std::abs(g[0] - q[0]) + std::abs(g[1] - q[1]) +
+                std::abs(g[2] - q[2]);
+            // spatial (8 bits) * range (8 bits): 16-bit weights
+            int w = ((wRow[a] * wCol[b]) >> 8) * range[diff];
+            const uchar *v = lo[a] + cx[b];
+            acc0 += w * v[0];
+            acc1 += w * v[1];
+            acc2 += w * v[2];
+            sum += w;
+          }
+        }
+        int half = sum / 2;
+        d[0] = (uchar)((acc0 + half) / sum);
+        d[1] = (uchar)((acc1 + half) / sum);
+        d[2] = (uchar)((acc2 + half) / sum);
+      }
+    }
+  });
+  return 0;
+}
+
+int processScaled(cv::Mat &src, cv::Mat &dst, int scale, const FilterFn &fn,
+                  ScaledBuffers &buf) {
+  if (scale <= 1)
+    return fn(src, dst);
+
+  cv::Size low(std::max(1, src.cols / scale), std::max(1, src.rows / scale));
+  cv::resize(src, buf.small, low, 0, 0, cv::INTER_AREA);
+  if (fn(buf.small, buf.smallDst) != 0)
+    return -1;
+
+  cv::Mat *out = &buf.smallDst;
+  if (buf.smallDst.type() == CV_8UC1) {
+    cv::cvtColor(buf.smallDst, buf.smallBgr, cv::COLOR_GRAY2BGR);
+    out = &buf.smallBgr;
+  }
+  return jointBilateralUpsample(buf.small, *out, src, dst);
+}
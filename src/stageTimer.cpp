@@ -0,0 +1,146 @@
+/**
+ * stageTimer.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Windowed stage statistics, the metrics file dump and the HUD overlay.
+ */
+
+#include "../include/stageTimer.h"
+#include <cstdio>
+#include <iostream>
+
+const char *stageName(Stage stage) {
+  static const char *names[] = {"capture",    "filter",     "faces",
+                                "depth_pre",  "depth_infer", "depth_post",
+                                "display",    "encode"};
+  return names[(int)stage];
+}
+
+static const int STAGES = (int)Stage::Count;
+
+MetricsWindow::MetricsWindow()
+    : last_(STAGES, std::vector<uint64_t>(LatencyHistogram::BUCKETS, 0)),
+      lastSum_(STAGES, 0), stats_(STAGES),
+      lastTime_(std::chrono::steady_clock::now()) {
+  for (int s = 0; s < STAGES; s++)
+    stats_[s] = {(Stage)s, 0, 0, 0, 0, 0, 0};
+}
+
+const std::vector<StageStats> &MetricsWindow::update() {
+  auto now = std::chrono::steady_clock::now();
+  double secs = std::chrono::duration<double>(now - lastTime_).count();
+  lastTime_ = now;
+
+  for (int s = 0; s < STAGES; s++) {
+    uint64_t sum;
+    StageMetrics::get().histogram((Stage)s).snapshot(counts_, sum);
+
+    // counts in this window, and the bucket holding the 50th/99th sample
+    uint64_t n = 0;
+    for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+      uint64_t c = counts_[b] - last_[s][b];
+      last_[s][b] = counts_[b];
+      counts_[b] = c;
+      n += c;
+    }
+    StageStats &st = stats_[s];
+    st.count = n;
+    st.perSec = secs > 0 ? n / secs : 0;
+    st.meanMs = n > 0 ? (sum - lastSum_[s]) / 1000.0 / n : 0;
+    lastSum_[s] = sum;
+    st.p50Ms = st.p99Ms = st.maxMs = 0;
+    uint64_t seen = 0, r50 = (n + 1) / 2, r99 = (n * 99 + 99) / 100;
+    for (int b = 0; b < LatencyHistogram::BUCKETS && n > 0; b++) {
+      if (counts_[b] == 0)
+        continue;
+      double ms = LatencyHistogram::bucketValue(b) / 1000.0;
+      if (seen < r50 && seen + counts_[b] >= r50)
+        st.p50Ms = ms;
+      if (seen < r99 && seen + counts_[b] >= r99)
+        st.p99Ms = ms;
+      st.maxMs = ms;
+      seen += counts_[b];
+    }
+  }
+  return stats_;
+}
+
+MetricsDumper::MetricsDumper(const std::string &path, double seconds)
+    : out_(path, std::ios::app), seconds_(seconds > 0 ? seconds : 5) {
+  json_ = path.size() > 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+  start_ = last_ = std::chrono::steady_clock::now();
+  if (!out_) {
+    std::cerr << "Unable to write metrics to " << path << std::endl;
+    return;
+  }
+  if (!json_ && out_.tellp() == 0)
+    out_ << "time_s,stage,count,per_s,p50_ms,p99_ms,mean_ms,max_ms\n";
+}
+
+void MetricsDumper::maybeDump() {
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - last_).count() >= seconds_)
+    dump();
+}
+
+void MetricsDumper::dump() {
+  if (!out_.is_open())
+    return;
+  last_ = std::chrono::steady_clock::now();
+  double t = std::chrono::duration<double>(last_ - start_).count();
+  char line[256];
+
+  if (json_)
+    out_ << "{\"time_s\": " << t << ", \"stages\": {";
+  bool first = true;
+  for (const StageStats &st : window_.update()) {
+    if (st.count == 0)
+      continue;
+    if (json_) {
+      snprintf(line, sizeof(line),
+               "%s\"%s\": {\"count\": %llu, \"per_s\": %.2f, "
+               "\"p50_ms\": %.3f, \"p99_ms\": %.3f, \"mean_ms\": %.3f, "
+               "\"max_ms\": %.3f}",
+               first ? "" : ", ", stageName(st.stage),
+               (unsigned long long)st.count, st.perSec, st.p50Ms, st.p99Ms,
+               st.meanMs, st.maxMs);
+    } else {
+      snprintf(line, sizeof(line), "%.2f,%s,%llu,%.2f,%.3f,%.3f,%.3f,%.3f\n",
+               t, stageName(st.stage), (unsigned long long)st.count,
+               st.perSec, st.p50Ms, st.p99Ms, st.meanMs, st.maxMs);
+    }
+    out_ << line;
+    first = false;
+  }
+  if (json_)
+    out_ << "}}\n";
+  out_.flush();
+}
+
+void drawMetricsHud(cv::Mat &frame, const MetricsWindow &window) {
+  std::vector<std::string> lines;
+  char line[96];
+  snprintf(line, sizeof(line), "%.1f fps",
+           window.stats(Stage::Display).count > 0
+               ? window.stats(Stage::Display).perSec
+               : window.stats(Stage::Filter).perSec);
+  lines.push_back(line);
+  for (const StageStats &st : window.stats()) {
+    if (st.count == 0)
+      continue;
+    snprintf(line, sizeof(line), "%-11s p50 %6.2f  p99 %6.2f ms",
+             stageName(st.stage), st.p50Ms, st.p99Ms);
+    lines.push_back(line);
+  }
+
+  int lineH = 18;
+  cv::Rect box(5, 5, 300, lineH * (int)lines.size() + 8);
+  box &= cv::Rect(0, 0, frame.cols, frame.rows);
+  if (box.area() == 0)
+    return;
+  // darken the background so the text reads on any frame
+  cv::Mat area = frame(box);
+  area.convertTo(area, -1, 0.4, 0);
+  for (size_t i = 0; i < lines.size(); i++)
+    cv::putText(frame, lines[i], cv::Point(10, 5 + lineH * (int)(i + 1)),
+                cv::FONT_HERSHEY_PLAIN, 1.0, cv::Scalar(255, 255, 255), 1);
+}
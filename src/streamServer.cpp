@@ -0,0 +1,224 @@
+/**
+ * streamServer.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Per-stream readers and a shared, round-robin filter worker pool.
+ */
+
+#include "../include/streamServer.h"
+#include "../include/stageTimer.h"
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+StreamServer::StreamServer(int workers, int queueDepth)
+    : workers_(std::max(1, workers)), queueDepth_(std::max(1, queueDepth)),
+      running_(false), cursor_(0) {}
+
+StreamServer::~StreamServer() { stop(); }
+
+int StreamServer::addStream(const StreamConfig &cfg) {
+  if (!threads_.empty())
+    return -1;
+  std::unique_ptr<Stream> s(new Stream());
+  s->cfg = cfg;
+  bool raw = isRawFramePath(cfg.input);
+  if (raw ? !s->raw.open(cfg.input) : !s->cap.open(cfg.input)) {
+    std::cerr << "Unable to open input: " << cfg.input << std::endl;
+    return -1;
+  }
+  s->ring.reset(new SpscRing<FrameSlot>(queueDepth_));
+
+  cv::Size size;
+  if (raw) {
+    // the stream's own fps paces it, the replay just hands out views
+    s->replay.reset(new RawReplay(s->raw, 0, cfg.loop));
+    s->inputFps = s->raw.fps();
+  } else {
+    s->inputFps = s->cap.get(cv::CAP_PROP_FPS);
+    size = cv::Size((int)s->cap.get(cv::CAP_PROP_FRAME_WIDTH),
+                    (int)s->cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+  }
+  if (size.width > 0 && size.height > 0)
+    s->ring->forEachSlot(
+        [&](FrameSlot &slot) { slot.frame.create(size, CV_8UC3); });
+
+  streams_.push_back(std::move(s));
+  return (int)streams_.size() - 1;
+}
+
+bool StreamServer::start() {
+  if (streams_.empty() || !threads_.empty())
+    return false;
+  running_.store(true);
+  auto now = std::chrono::steady_clock::now();
+  for (auto &s : streams_) {
+    s->reportTime = now;
+    threads_.emplace_back(&StreamServer::readerLoop, this, s.get());
+  }
+  for (int i = 0; i < workers_; i++)
+    threads_.emplace_back(&StreamServer::workerLoop, this);
+  return true;
+}
+
+void StreamServer::stop() {
+  running_.store(false);
+  ready_.notify_all();
+  for (auto &t : threads_)
+    t.join();
+  threads_.clear();
+  for (auto &s : streams_)
+    s->writer.release();
+}
+
+void StreamServer::readerLoop(Stream *s) {
+  typedef std::chrono::steady_clock Clock;
+  auto period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(s->cfg.fps > 0 ? 1.0 / s->cfg.fps : 0));
+  auto due = Clock::now();
+  cv::Mat scratch;
+
+  while (running_.load()) {
+    if (s->cfg.fps > 0) {
+      std::this_thread::sleep_until(due);
+      due += period;
+      // far behind (e.g. a slow decode): don't burst to catch up
+      if (Clock::now() > due + period)
+        due = Clock::now();
+    }
+
+    // paced streams act like a live source and drop when the workers fall
+    // behind; unpaced ones wait for space so no frame is lost
+    FrameSlot *slot = s->ring->writeSlot();
+    while (!slot && s->cfg.fps <= 0 && running_.load()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+      slot = s->ring->writeSlot();
+    }
+    if (!running_.load())
+      break;
+
+    cv::Mat &target = slot ? slot->frame : scratch;
+    {
+      ScopedTimer timer(Stage::Capture);
+      if (s->replay) {
+        if (!s->replay->next(target))
+          target.release();
+      } else {
+        s->cap >> target;
+      }
+      if (target.empty() && s->cfg.loop && !s->replay) {
+        s->cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+        s->cap >> target;
+      }
+    }
+    if (target.empty())
+      break;
+
+    if (!slot) {
+      s->dropped++;
+      continue;
+    }
+    slot->mode = s->cfg.mode;
+    s->ring->commitWrite();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.notify_one();
+  }
+
+  s->ended.store(true);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ready_.notify_all();
+}
+
+StreamServer::Stream *StreamServer::claimStream() {
+  size_t n = streams_.size();
+  for (size_t k = 0; k < n; k++) {
+    size_t i = (cursor_ + k) % n;
+    Stream *s = streams_[i].get();
+    if (!s->busy && !s->ring->empty()) {
+      s->busy = true;
+      cursor_ = i + 1;
+      return s;
+    }
+  }
+  return nullptr;
+}
+
+bool StreamServer::allDone() {
+  for (auto &s : streams_) {
+    if (!s->ended.load() || s->busy || !s->ring->empty())
+      return false;
+  }
+  return true;
+}
+
+void StreamServer::writeOutput(Stream *s) {
+  if (s->cfg.output.empty())
+    return;
+  if (!s->writer.isOpened()) {
+    double fps = s->cfg.fps > 0 ? s->cfg.fps : s->inputFps;
+    s->writer.open(s->cfg.output, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                   fps > 0 ? fps : 30, s->out.size());
+    if (!s->writer.isOpened()) {
+      std::cerr << "Unable to open output: " << s->cfg.output << std::endl;
+      s->cfg.output.clear();
+      return;
+    }
+  }
+  ScopedTimer timer(Stage::Encode);
+  s->writer.write(asBgr(s->out, s->bgr));
+}
+
+void StreamServer::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_.load()) {
+    Stream *s = claimStream();
+    if (!s) {
+      if (allDone())
+        break;
+      ready_.wait_for(lock, std::chrono::milliseconds(50));
+      continue;
+    }
+    lock.unlock();
+
+    // the stream is ours until busy is cleared, so its state, writer and
+    // ring consumer side are not shared with another worker
+    FrameSlot *slot = s->ring->readSlot();
+    applyEffect(slot->mode, slot->frame, s->out, s->state);
+    writeOutput(s);
+    s->ring->commitRead();
+    s->frames++;
+
+    lock.lock();
+    s->busy = false;
+    ready_.notify_one();
+  }
+  ready_.notify_all();
+}
+
+bool StreamServer::finished() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return allDone();
+}
+
+std::string StreamServer::stats() {
+  std::ostringstream ss;
+  auto now = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < streams_.size(); i++) {
+    Stream &s = *streams_[i];
+    long frames = s.frames.load();
+    double secs = std::chrono::duration<double>(now - s.reportTime).count();
+    double fps = secs > 0 ? (frames - s.reportFrames) / secs : 0;
+    s.reportFrames = frames;
+    s.reportTime = now;
+
+    char line[256];
+    snprintf(line, sizeof(line),
+             "[%zu] %s mode %c: %6.1f fps (target %s), %ld frames, "
+             "%ld dropped, queue %zu%s\n",
+             i, s.cfg.input.c_str(), s.cfg.mode, fps,
+             s.cfg.fps > 0 ? std::to_string((int)s.cfg.fps).c_str() : "max",
+             frames, s.dropped.load(), s.ring->size(),
+             s.ended.load() ? ", ended" : "");
+    ss << line;
+  }
+  return ss.str();
+}
@@ -0,0 +1,220 @@
+/**
+ * temporal.cpp
+ * Shivang Patel (shivang2402) - 2026-01-23
+ * Frame history ring with running sums, and the effects built on it.
+ */
+
+#include "../include/temporal.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+FrameHistory::FrameHistory(int capacity, bool sums) {
+  configure(capacity, sums);
+}
+
+void FrameHistory::configure(int capacity, bool sums) {
+  slots_.assign(std::max(1, std::min(capacity, 256)), cv::Mat());
+  sum_.release();
+  sums_ = sums;
+  clear();
+}
+
+void FrameHistory::clear() {
+  head_ = capacity() - 1; // the first push lands in slot 0
+  count_ = 0;
+}
+
+void FrameHistory::push(const cv::Mat &frame) {
+  const cv::Mat &newest = slots_[head_];
+  if (count_ > 0 &&
+      (frame.size() != newest.size() || frame.type() != newest.type()))
+    clear();
+
+  int next = (head_ + 1) % capacity();
+  cv::Mat &slot = slots_[next];
+  bool evict = count_ == capacity();
+
+  if (!sums_) {
+    frame.copyTo(slot);
+  } else {
+    slot.create(frame.size(), frame.type());
+    if (count_ == 0) {
+      sum_.create(frame.size(), CV_16UC(frame.channels()));
+      sum_.setTo(0);
+    }
+    // add the new frame, take out the one it replaces, and copy it into
+    // its slot, in one pass
+    int n = frame.cols * frame.channels();
+    parallelRows(frame.rows, [&](int r0, int r1) {
+      for (int i = r0; i < r1; i++) {
+        const uchar *s = frame.ptr<uchar>(i);
+        uchar *d = slot.ptr<uchar>(i);
+        uint16_t *acc = sum_.ptr<uint16_t>(i);
+        if (evict) {
+          for (int j = 0; j < n; j++) {
+            acc[j] = (uint16_t)(acc[j] + s[j] - d[j]);
+            d[j] = s[j];
+          }
+        } else {
+          for (int j = 0; j < n; j++) {
+            acc[j] = (uint16_t)(acc[j] + s[j]);
+            d[j] = s[j];
+          }
+        }
+      }
+    });
+  }
+
+  head_ = next;
+  count_ = std::min(count_ + 1, capacity());
+}
+
+const cv::Mat &FrameHistory::at(int k) const {
+  k = std::max(0, std::min(k, count_ - 1));
+  return slots_[(head_ - k + capacity()) % capacity()];
+}
+
+// 1/n in 16-bit fixed point, so a mean is a multiply and a shift
+static uint32_t reciprocal(int n) { return (65536u + n / 2) / n; }
+
+int echoTrails(FrameHistory &history, cv::Mat &dst, int gap, int echoes) {
+  if (history.size() == 0)
+    return -1;
+  const int MAX_TAPS = 8;
+  int taps = std::max(1, std::min(echoes + 1, MAX_TAPS));
+  gap = std::max(1, gap);
+
+  // 1/2, 1/4, 1/8... of 256, the oldest echo takes the remainder
+  int weight[MAX_TAPS], left = 256;
+  for (int k = 0; k < taps; k++) {
+    weight[k] = k + 1 < taps ? 256 >> (k + 1) : left;
+    left -= weight[k];
+  }
+
+  const cv::Mat &cur = history.at(0);
+  dst.create(cur.size(), cur.type());
+  int n = cur.cols * cur.channels();
+  parallelRows(cur.rows, [&](int r0, int r1) {
+    const uchar *src[MAX_TAPS];
+    for (int i = r0; i < r1; i++) {
+      for (int k = 0; k < taps; k++)
+        src[k] = history.at(k * gap).ptr<uchar>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int j = 0; j < n; j++) {
+        int acc = 128;
+        for (int k = 0; k < taps; k++)
+          acc += weight[k] * src[k][j];
+        d[j] = (uchar)(acc >> 8);
+      }
+    }
+  });
+  return 0;
+}
+
+int temporalAverage(FrameHistory &history, cv::Mat &dst) {
+  if (history.size() == 0 || !history.hasSums())
+    return -1;
+  const cv::Mat &sum = history.sum();
+  dst.create(sum.size(), CV_8UC(sum.channels()));
+  uint32_t recip = reciprocal(history.size());
+  int n = sum.cols * sum.channels();
+
+  parallelRows(sum.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uint16_t *s = sum.ptr<uint16_t>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int j = 0; j < n; j++)
+        d[j] = (uchar)((s[j] * recip + 32768) >> 16);
+    }
+  });
+  return 0;
+}
+
+int temporalMedian(FrameHistory &history, cv::Mat &dst, int frames) {
+  if (history.size() == 0)
+    return -1;
+  // an odd count that the history already holds
+  int taps = std::max(1, std::min({frames, history.size(), 9}));
+  if (taps % 2 == 0)
+    taps--;
+
+  const cv::Mat &cur = history.at(0);
+  dst.create(cur.size(), cur.type());
+  int n = cur.cols * cur.channels();
+  parallelRows(cur.rows, [&](int r0, int r1) {
+    const uchar *src[9];
+    for (int i = r0; i < r1; i++) {
+      for (int k = 0; k < taps; k++)
+        src[k] = history.at(k).ptr<uchar>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int j = 0; j < n; j++) {
+        // insertion sort of at most 9 values
+        uchar v[9];
+        for (int k = 0; k < taps; k++) {
+          uchar x = src[k][j];
+          int m = k;
+          for (; m > 0 && v[m - 1] > x; m--)
+            v[m] = v[m - 1];
+          v[m] = x;
+        }
+        d[j] = v[taps / 2];
+      }
+    }
+  });
+  return 0;
+}
+
+int motionHighlight(FrameHistory &history, cv::Mat &dst, int threshold) {
+  if (history.size() == 0 || !history.hasSums() ||
+      history.at(0).type() != CV_8UC3)
+    return -1;
+  const cv::Mat &cur = history.at(0);
+  const cv::Mat &sum = history.sum();
+  dst.create(cur.size(), CV_8UC3);
+  uint32_t recip = reciprocal(history.size());
+  int limit = 3 * threshold;
+
+  parallelRows(cur.rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      const uchar *s = cur.ptr<uchar>(i);
+      const uint16_t *acc = sum.ptr<uint16_t>(i);
+      uchar *d = dst.ptr<uchar>(i);
+      for (int j = 0; j < cur.cols; j++, s += 3, acc += 3, d += 3) {
+        int diff = 0;
+        for (int c = 0; c < 3; c++) {
+          int mean = (int)((acc[c] * recip + 32768) >> 16);
+          diff += std::abs(s[c] - mean);
+        }
+        if (diff > limit) {
+          d[0] = (uchar)(s[0] >> 1);
+          d[1] = (uchar)(s[1] >> 1);
+          d[2] = (uchar)((s[2] + 255) >> 1);
+        } else {
+          uchar y = (uchar)((s[0] + 2 * s[1] + s[2]) >> 3); // half grey
+          d[0] = d[1] = d[2] = y;
+        }
+      }
+    }
+  });
+  return 0;
+}
+
+int slitScan(FrameHistory &history, cv::Mat &dst, int frames) {
+  if (history.size() == 0)
+    return -1;
+  const cv::Mat &cur = history.at(0);
+  dst.create(cur.size(), cur.type());
+  size_t rowBytes = cur.cols * cur.elemSize();
+  int rows = cur.rows;
+
+  parallelRows(rows, [&](int r0, int r1) {
+    for (int i = r0; i < r1; i++) {
+      int delay = rows > 1 ? i * (frames - 1) / (rows - 1) : 0;
+      std::memcpy(dst.ptr<uchar>(i), history.at(delay).ptr<uchar>(i),
+                  rowBytes);
+    }
+  });
+  return 0;
+}
@@ -17,6 +17,8 @@
 // prototypes for the functions to test
 int blur5x5_1( cv::Mat &src, cv::Mat &dst );
 int blur5x5_2( cv::Mat &src, cv::Mat &dst );
+int blur5x5_3( cv::Mat &src, cv::Mat &dst );
+bool setBlurSimdPath( const char *name );
 
 // returns a double which gives time in seconds
 double getTime() {
@@ -87,6 +89,23 @@ int main(int argc, char *argv[]) {  // main function, execution starts here
 
   // print the results
   printf("Time per image (2): %.4lf seconds\n", difference );
+
+  //////////////////////////////
+  // version 3, once for each SIMD path this CPU supports
+  const char *paths[] = { "scalar", "sse4.1", "avx2", "neon" };
+  for(int p=0;p<4;p++) {
+    if( !setBlurSimdPath( paths[p] ) )
+      continue;
+
+    startTime = getTime();
+    for(int i=0;i<Ntimes;i++) {
+      blur5x5_3( src, dst );
+    }
+    endTime = getTime();
+
+    difference = (endTime - startTime) / Ntimes;
+    printf("Time per image (3, %s): %.4lf seconds\n", paths[p], difference );
+  }
   
   // terminate the program
   printf("Terminating\n");
@@ -2,47 +2,697 @@
  * vidDisplay.cpp
  * Shivang Patel (shivang2402) - 2026-01-23
  * Live video capture with real-time filters.
- * Keys: q=quit, s=save, c/g/h/p/b/x/y/m/l/f/1/2/3/d/4 = filters
+ * Keys: q=quit, s=save, r=record, i=timings,
+ *       c/g/h/p/b/x/y/m/l/f/1/2/3/d/4/k/5-9 = filters
+ *
+ * Headless mode: vid -i <video | image pattern> [-o out.avi] [-m mode]
+ * processes a file without camera or display and reports frames per second.
+ * -w <n> runs capture, n filter workers and display on separate threads.
+ * Stage timers are always on; --hud (or the i key) draws them on the frame
+ * and --metrics <file.csv|.json> saves them periodically.
+ * --stream <spec> (repeatable) filters several inputs at once on a shared
+ * worker pool, see parseStreamSpec.
+ * Recording and snapshots are encoded on a writer thread (see recorder.h).
+ * --capture-raw <file.vraw> keeps the unfiltered camera or input frames,
+ * and -i <file.vraw> replays them without decoding (see rawFrames.h).
+ * --config <file> reads the same options from a file, one "key value" per
+ * line (keys are the long option names without "--", e.g. depth-threads 8).
  */
 
-#include "DA2Network.hpp"
-#include "faceDetect.h"
-#include "filters.h"
+#include "effects.h"
+#include "filterKernels.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "rawFrames.h"
+#include "recorder.h"
+#include "stageTimer.h"
+#include "streamServer.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
+#include <fstream>
 #include <iostream>
 #include <opencv2/opencv.hpp>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
-static DA2Network *depthNetwork = nullptr;
-static bool depthNetworkLoaded = false;
-static bool depthModelWarned = false;
+struct Options {
+  std::string input;  // video, image sequence (img_%04d.png) or .vraw
+  std::string output; // encoded output, empty = discard
+  std::string fourcc = "MJPG";
+  double fps = 0; // output frame rate, 0 = take it from the input
+  char mode = 'c';
+  PipelineConfig pipeline{0, 4, QueuePolicy::Block}; // 0 workers = 1 thread
+  bool asyncDepth = false;
+  DepthPolicy depthPolicy;
+  DA2Config depthConfig;
+  bool depthBench = false;
+  FaceDetectorConfig faceConfig;
+  std::vector<StreamConfig> streams; // multi-stream server mode
+  int depthBatch = 1;                // max frames per depth batch
+  int depthBatchWait = 5;            // ms to wait for a batch to fill
+  double seconds = 0;                // server run time, 0 = until inputs end
+  bool hud = false;                  // stage timings drawn on the frame
+  std::string metricsPath;           // periodic .csv or .json stage dump
+  double metricsEvery = 5;           // seconds between dumps
+  TemporalConfig temporal;           // modes 5-9
+  FogStyle fog;                      // mode 4 and fog chains
+  DirtyTileConfig dirty;             // --dirty-tiles
+  bool dirtyTiles = false;
+  RecorderConfig recorder;           // r and s keys in live mode
+  bool record = false;               // start recording at launch
+  std::string captureRaw;            // .vraw copy of the unfiltered input
+  double replaySpeed = 0;            // .vraw input pace, 0 = flat out
+};
+
+static void usage(const char *prog) {
+  std::cerr << "Usage: " << prog << " [options]\n"
+            << "  (no options)      live camera with display\n"
+            << "  -i <path>         headless: read a video file or image "
+               "sequence\n"
+            << "  -o <path>         headless: write filtered video\n"
+            << "  -m <key>          filter mode (" << EFFECT_KEYS << ")\n"
+            << "  -g <chain>        effect chain for mode k, e.g. fog>cartoon\n"
+            << "  -c <fourcc>       output codec (default MJPG)\n"
+            << "  -r <fps>          output frame rate (default: input rate)\n"
+            << "  -w <n>            threaded pipeline with n filter workers\n"
+            << "  -q <n>            queue slots per worker (default 4)\n"
+            << "  -P block|drop     pipeline policy when a queue is full\n"
+            << "  -t <n>            threads per filter call (default: all "
+               "cores)\n"
+            << "  --kernels <isa>   filter kernels: baseline, avx2 or avx512 "
+               "(default: best)\n"
+            << "  -a                async depth: the model runs on its own "
+               "thread (not with --stream)\n"
+            << "  --depth-every <n> async: infer every n frames (default 1)\n"
+            << "  --depth-stale <n> async: wait if the map is older than n "
+               "frames (default 30)\n"
+            << "  --depth-blend <w> async: weight of the previous map, 0-1 "
+               "(default 0)\n"
+            << "  --depth-model <m> vits, vitb or a path to an .onnx file\n"
+            << "  --depth-size <n>  input size for dynamic-shape models "
+               "(252/364/518)\n"
+            << "  --depth-threads <n>   ONNX Runtime intra-op threads "
+               "(default 4)\n"
+            << "  --depth-inter <n>     inter-op threads (default: ORT)\n"
+            << "  --depth-exec seq|par  execution mode (default seq)\n"
+            << "  --depth-opt <0-3>     graph optimization level (default 3)\n"
+            << "  --depth-save-opt <path> save the optimized model\n"
+            << "  --depth-lowres    keep depth at the model's size; fog "
+               "samples it directly\n"
+            << "  --fog-colour <r,g,b>  mode 4 and fog chains (default "
+               "255,255,255)\n"
+            << "  --fog-density <f> how fast fog thickens with depth "
+               "(default 3)\n"
+            << "  --depth-bench     time the depth model for several settings "
+               "and exit\n"
+            << "  --face-scale <f>  detector scale step (default 1.1)\n"
+            << "  --face-neighbors <n>  detector min neighbors (default 3)\n"
+            << "  --face-min <px>   smallest face width (default: any)\n"
+            << "  --face-max <px>   largest face width (default: any)\n"
+            << "  --face-downscale <n>  detect at 1/n size (default 2)\n"
+            << "  --stream <spec>   add a stream: path[,m=<key>][,fps=<n>]"
+               "[,o=<out>][,loop]\n"
+            << "  --depth-batch <n> streams: run up to n depth frames as one "
+               "batch\n"
+            << "  --depth-batch-wait <ms>  wait for a batch to fill "
+               "(default 5)\n"
+            << "  --seconds <n>     streams: stop after n seconds\n"
+            << "  --scale <k>=<n>[,...]  run mode k at 1/n size (2 or 4), "
+               "e.g. 3=2,l=4\n"
+            << "  --hud             draw fps and stage timings on the frame "
+               "(key i)\n"
+            << "  --metrics <file>  append stage timings to a .csv or .json "
+               "file\n"
+            << "  --metrics-every <s>  seconds between dumps (default 5)\n"
+            << "  --no-timers       turn the stage timers off\n"
+            << "  --avg-frames <n>  modes 6/7: frames averaged (default 8)\n"
+            << "  --median-frames <n>  mode 9: odd, up to 9 (default 5)\n"
+            << "  --echo-gap <n>    mode 5: frames between echoes (default "
+               "4)\n"
+            << "  --echoes <n>      mode 5: number of echoes (default 3)\n"
+            << "  --motion-threshold <n>  mode 7: change that counts as "
+               "motion (default 20)\n"
+            << "  --slit-frames <n> mode 8: delay of the bottom row "
+               "(default 30)\n"
+            << "  --dirty-tiles     modes b/m/l/2 only redo tiles that "
+               "changed\n"
+            << "  --tile-size <px>  dirty tile side (default 32)\n"
+            << "  --tile-threshold <n>  change per byte that counts "
+               "(default 16)\n"
+            << "  --tile-refresh <n>  redo every tile every n frames "
+               "(default 60, 0 = never)\n"
+            << "  --record <path>   live: record from the start (r key "
+               "toggles)\n"
+            << "  --record-codec <fourcc>  recording codec (default MJPG)\n"
+            << "  --record-container <ext>  file type of unnamed "
+               "recordings (default avi)\n"
+            << "  --record-fps <n>  recording frame rate (default: camera)\n"
+            << "  --record-quality <0-100>  codec and jpg quality "
+               "(default 90)\n"
+            << "  --record-queue <n>  frames buffered for the writer "
+               "(default 8)\n"
+            << "  --snapshot-format png|jpg  s key image type (default "
+               "png)\n"
+            << "  --capture-raw <file.vraw>  also save the frames as "
+               "captured, unfiltered\n"
+            << "  --replay-speed <x>  .vraw input: play at x times the "
+               "recorded rate (default 0 = as fast as possible)\n"
+            << "  --config <file>   read options from a file"
+            << std::endl;
+}
 
-static bool ensureDepthNetwork() {
-  if (depthNetworkLoaded)
-    return true;
-  if (depthModelWarned)
+static bool parseArgs(const std::vector<std::string> &args, Options &opts);
+
+// Stream spec: input path, then comma-separated settings, e.g.
+// "cam1.mp4,m=4,fps=15,o=out1.avi,loop"
+static bool parseStreamSpec(const std::string &spec, StreamConfig &cfg) {
+  std::istringstream ss(spec);
+  std::string item;
+  std::getline(ss, cfg.input, ',');
+  while (std::getline(ss, item, ',')) {
+    if (item == "loop") {
+      cfg.loop = true;
+    } else if (item.compare(0, 2, "m=") == 0 && item.size() == 3 &&
+               isEffectKey(item[2])) {
+      cfg.mode = item[2];
+    } else if (item.compare(0, 4, "fps=") == 0) {
+      cfg.fps = std::atof(item.c_str() + 4);
+    } else if (item.compare(0, 2, "o=") == 0) {
+      cfg.output = item.substr(2);
+    } else {
+      std::cerr << "Unknown stream setting: " << item << std::endl;
+      return false;
+    }
+  }
+  return !cfg.input.empty();
+}
+
+// Options file: "key value" or "key=value" per line, # starts a comment
+static bool parseConfigFile(const std::string &path, Options &opts) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "Unable to read config: " << path << std::endl;
+    return false;
+  }
+  std::vector<std::string> args;
+  std::string line;
+  while (std::getline(in, line)) {
+    line = line.substr(0, line.find('#'));
+    std::replace(line.begin(), line.end(), '=', ' ');
+    std::istringstream ss(line);
+    std::string key, value;
+    if (!(ss >> key))
+      continue;
+    args.push_back(key.size() > 1 && key[0] == '-' ? key : "--" + key);
+    if (ss >> value)
+      args.push_back(value);
+  }
+  return parseArgs(args, opts);
+}
+
+static bool parseArgs(const std::vector<std::string> &args, Options &opts) {
+  int argc = (int)args.size();
+  for (int i = 0; i < argc; i++) {
+    std::string arg = args[i];
+    if (arg == "-h" || arg == "--help")
+      return false;
+    if (arg == "-a" || arg == "--async-depth") {
+      opts.asyncDepth = true;
+      continue;
+    }
+    if (arg == "--depth-bench") {
+      opts.depthBench = true;
+      continue;
+    }
+    if (arg == "--dirty-tiles") {
+      opts.dirtyTiles = true;
+      continue;
+    }
+    if (arg == "--depth-lowres") {
+      opts.depthConfig.lowResOutput = true;
+      continue;
+    }
+    if (arg == "--hud") {
+      opts.hud = true;
+      continue;
+    }
+    if (arg == "--no-timers") {
+      StageMetrics::get().setEnabled(false);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    if (arg == "-i") {
+      opts.input = args[++i];
+    } else if (arg == "-o") {
+      opts.output = args[++i];
+    } else if (arg == "-m") {
+      opts.mode = args[++i][0];
+      if (!isEffectKey(opts.mode)) {
+        std::cerr << "Unknown mode: " << opts.mode << std::endl;
+        return false;
+      }
+    } else if (arg == "-g") {
+      if (!setEffectChain(args[++i]))
+        return false;
+      opts.mode = 'k';
+    } else if (arg == "-c") {
+      opts.fourcc = args[++i];
+      if (opts.fourcc.size() != 4) {
+        std::cerr << "fourcc must be 4 characters" << std::endl;
+        return false;
+      }
+    } else if (arg == "-r") {
+      opts.fps = std::atof(args[++i].c_str());
+    } else if (arg == "-w") {
+      opts.pipeline.workers = std::atoi(args[++i].c_str());
+    } else if (arg == "-q") {
+      opts.pipeline.queueDepth = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (arg == "--depth-every") {
+      opts.depthPolicy.inferEvery = std::atoi(args[++i].c_str());
+    } else if (arg == "--depth-stale") {
+      opts.depthPolicy.maxStaleness = std::atoi(args[++i].c_str());
+    } else if (arg == "--depth-blend") {
+      opts.depthPolicy.blend =
+          std::min(1.0f, std::max(0.0f, (float)std::atof(args[++i].c_str())));
+    } else if (arg == "--depth-model") {
+      opts.depthConfig.model = args[++i];
+    } else if (arg == "--depth-size") {
+      opts.depthConfig.inputSize = std::atoi(args[++i].c_str());
+    } else if (arg == "--depth-threads") {
+      opts.depthConfig.intraThreads = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (arg == "--depth-inter") {
+      opts.depthConfig.interThreads = std::atoi(args[++i].c_str());
+    } else if (arg == "--depth-exec") {
+      std::string e = args[++i];
+      if (e != "seq" && e != "par") {
+        std::cerr << "Unknown execution mode: " << e << std::endl;
+        return false;
+      }
+      opts.depthConfig.parallelExecution = (e == "par");
+    } else if (arg == "--depth-opt") {
+      opts.depthConfig.optLevel = std::atoi(args[++i].c_str());
+    } else if (arg == "--depth-save-opt") {
+      opts.depthConfig.optimizedModelPath = args[++i];
+    } else if (arg == "--fog-colour") {
+      int r, g, b;
+      if (std::sscanf(args[++i].c_str(), "%d,%d,%d", &r, &g, &b) != 3) {
+        std::cerr << "Bad fog colour: " << args[i] << std::endl;
+        return false;
+      }
+      opts.fog.colour = cv::Vec3b(cv::saturate_cast<uchar>(b),
+                                  cv::saturate_cast<uchar>(g),
+                                  cv::saturate_cast<uchar>(r));
+    } else if (arg == "--fog-density") {
+      opts.fog.density = (float)std::max(0.0, std::atof(args[++i].c_str()));
+    } else if (arg == "--face-scale") {
+      opts.faceConfig.scaleFactor =
+          std::max(1.01, std::atof(args[++i].c_str()));
+    } else if (arg == "--face-neighbors") {
+      opts.faceConfig.minNeighbors = std::atoi(args[++i].c_str());
+    } else if (arg == "--face-min") {
+      int w = std::atoi(args[++i].c_str());
+      opts.faceConfig.minSize = cv::Size(w, w);
+    } else if (arg == "--face-max") {
+      int w = std::atoi(args[++i].c_str());
+      opts.faceConfig.maxSize = cv::Size(w, w);
+    } else if (arg == "--face-downscale") {
+      opts.faceConfig.downscale = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (arg == "--stream") {
+      StreamConfig cfg;
+      cfg.mode = opts.mode;
+      if (!parseStreamSpec(args[++i], cfg))
+        return false;
+      opts.streams.push_back(cfg);
+    } else if (arg == "--depth-batch") {
+      opts.depthBatch = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (arg == "--depth-batch-wait") {
+      opts.depthBatchWait = std::max(0, std::atoi(args[++i].c_str()));
+    } else if (arg == "--seconds") {
+      opts.seconds = std::atof(args[++i].c_str());
+    } else if (arg == "--scale") {
+      std::istringstream ss(args[++i]);
+      std::string item;
+      while (std::getline(ss, item, ',')) {
+        if (item.size() < 3 || item[1] != '=' ||
+            !setProcessingScale(item[0], std::atoi(item.c_str() + 2))) {
+          std::cerr << "Bad scale: " << item << std::endl;
+          return false;
+        }
+      }
+    } else if (arg == "--metrics") {
+      opts.metricsPath = args[++i];
+    } else if (arg == "--metrics-every") {
+      opts.metricsEvery = std::atof(args[++i].c_str());
+    } else if (arg == "--avg-frames") {
+      opts.temporal.averageFrames =
+          std::min(256, std::max(1, std::atoi(args[++i].c_str())));
+    } else if (arg == "--median-frames") {
+      opts.temporal.medianFrames =
+          std::min(9, std::max(1, std::atoi(args[++i].c_str())));
+    } else if (arg == "--echo-gap") {
+      opts.temporal.echoGap = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (arg == "--echoes") {
+      opts.temporal.echoes =
+          std::min(7, std::max(0, std::atoi(args[++i].c_str())));
+    } else if (arg == "--motion-threshold") {
+      opts.temporal.motionThreshold = std::atoi(args[++i].c_str());
+    } else if (arg == "--slit-frames") {
+      opts.temporal.slitFrames =
+          std::min(256, std::max(1, std::atoi(args[++i].c_str())));
+    } else if (arg == "--tile-size") {
+      opts.dirty.tile = std::max(8, std::atoi(args[++i].c_str()));
+    } else if (arg == "--tile-threshold") {
+      opts.dirty.threshold = std::max(0, std::atoi(args[++i].c_str()));
+    } else if (arg == "--tile-refresh") {
+      opts.dirty.refreshEvery = std::max(0, std::atoi(args[++i].c_str()));
+    } else if (arg == "--record") {
+      opts.recorder.path = args[++i];
+      opts.record = true;
+    } else if (arg == "--record-codec") {
+      opts.recorder.fourcc = args[++i];
+      if (opts.recorder.fourcc.size() != 4) {
+        std::cerr << "fourcc must be 4 characters" << std::endl;
+        return false;
+      }
+    } else if (arg == "--record-container") {
+      opts.recorder.container = args[++i];
+    } else if (arg == "--record-fps") {
+      opts.recorder.fps = std::atof(args[++i].c_str());
+    } else if (arg == "--record-quality") {
+      opts.recorder.quality =
+          std::min(100, std::max(0, std::atoi(args[++i].c_str())));
+    } else if (arg == "--record-queue") {
+      opts.recorder.queueDepth = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (arg == "--snapshot-format") {
+      opts.recorder.snapshotFormat = args[++i];
+      if (opts.recorder.snapshotFormat != "png" &&
+          opts.recorder.snapshotFormat != "jpg") {
+        std::cerr << "Snapshot format must be png or jpg" << std::endl;
+        return false;
+      }
+    } else if (arg == "--capture-raw") {
+      opts.captureRaw = args[++i];
+      if (!isRawFramePath(opts.captureRaw)) {
+        std::cerr << "--capture-raw needs a .vraw path" << std::endl;
+        return false;
+      }
+    } else if (arg == "--replay-speed") {
+      opts.replaySpeed = std::max(0.0, std::atof(args[++i].c_str()));
+    } else if (arg == "--config") {
+      if (!parseConfigFile(args[++i], opts))
+        return false;
+    } else if (arg == "-t") {
+      setFilterThreads(std::atoi(args[++i].c_str()));
+    } else if (arg == "--kernels") {
+      if (!setFilterKernels(args[++i].c_str())) {
+        std::cerr << "Kernels not available: " << args[i] << std::endl;
+        return false;
+      }
+    } else if (arg == "-P") {
+      std::string p = args[++i];
+      if (p == "block") {
+        opts.pipeline.policy = QueuePolicy::Block;
+      } else if (p == "drop") {
+        opts.pipeline.policy = QueuePolicy::DropOldest;
+      } else {
+        std::cerr << "Unknown policy: " << p << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+  if (opts.input.empty() && !opts.output.empty()) {
+    std::cerr << "-o requires -i" << std::endl;
     return false;
+  }
+  // one async depth service would mix every stream's frames into one map
+  if (opts.asyncDepth && !opts.streams.empty()) {
+    std::cerr << "-a does not work with --stream, use --depth-batch"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
 
-  if (depthNetwork == nullptr) {
-    depthNetwork = new DA2Network();
+// Times DA2Network::process for a grid of session settings on this host
+static int runDepthBench(const DA2Config &base) {
+  std::string path = findDepthModel(base);
+  if (path.empty()) {
+    std::cerr << "No depth model " << base.modelFile() << " in data/"
+              << std::endl;
+    return -1;
   }
 
-  std::vector<std::string> paths = {"../data/depth_anything_v2_vits.onnx",
-                                    "data/depth_anything_v2_vits.onnx"};
-  for (const auto &p : paths) {
-    if (depthNetwork->init(p)) {
-      depthNetworkLoaded = true;
-      return true;
+  cv::Mat frame(480, 640, CV_8UC3), depth;
+  cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+
+  std::vector<int> threads = {1, 2, 4};
+  int cores = (int)std::thread::hardware_concurrency();
+  if (cores > 4)
+    threads.push_back(cores);
+  std::vector<int> sizes = {252, 364, 518};
+  if (base.inputSize > 0)
+    sizes = {base.inputSize};
+
+  const int warmup = 2, runs = 10;
+  std::cout << "Depth benchmark: " << path << std::endl;
+  for (int par = 0; par < 2; par++) {
+    for (int t : threads) {
+      for (int size : sizes) {
+        DA2Config cfg = base;
+        cfg.intraThreads = t;
+        cfg.parallelExecution = par;
+        cfg.inputSize = size;
+        cfg.optimizedModelPath.clear();
+        DA2Network net;
+        if (!net.init(path, cfg))
+          continue;
+        // fixed-shape model: every size runs the same, time it once
+        if (net.inputSize().width != size && size != sizes.front())
+          continue;
+
+        for (int i = 0; i < warmup; i++)
+          net.process(frame, depth);
+        std::vector<double> ms;
+        for (int i = 0; i < runs; i++) {
+          auto t0 = std::chrono::steady_clock::now();
+          net.process(frame, depth);
+          ms.push_back(std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - t0)
+                           .count());
+        }
+        std::sort(ms.begin(), ms.end());
+        printf("%s threads %2d input %4d  median %8.1f ms  min %8.1f ms\n",
+               par ? "par" : "seq", t, net.inputSize().width, ms[runs / 2],
+               ms[0]);
+      }
     }
   }
+  return 0;
+}
 
-  depthModelWarned = true;
-  std::cerr << "Warning: No depth model found in data/" << std::endl;
-  return false;
+// --capture-raw: a second recorder that gets the frames as captured.
+// keepAll makes capture wait for the writer instead of dropping frames.
+static Recorder *startCaptureRecorder(const Options &opts, double fps,
+                                      bool keepAll) {
+  if (opts.captureRaw.empty())
+    return nullptr;
+  RecorderConfig cfg;
+  cfg.path = opts.captureRaw;
+  cfg.fps = fps;
+  cfg.queueDepth = 16;
+  cfg.dropWhenFull = !keepAll;
+  Recorder *rec = new Recorder(cfg);
+  rec->start();
+  rec->setRecording(true);
+  return rec;
 }
 
-int main(int argc, char *argv[]) {
+static void stopCaptureRecorder(Recorder *rec) {
+  if (!rec)
+    return;
+  rec->stop();
+  std::cout << rec->stats() << std::endl;
+  delete rec;
+}
+
+// Processes every frame of opts.input as fast as possible (a .vraw input
+// at --replay-speed), no display
+static int runHeadless(const Options &opts) {
+  cv::VideoCapture cap;
+  RawFrameReader raw;
+  bool isRaw = isRawFramePath(opts.input);
+  if (isRaw ? !raw.open(opts.input) : !cap.open(opts.input)) {
+    std::cerr << "Unable to open input: " << opts.input << std::endl;
+    return -1;
+  }
+  RawReplay replay(raw, opts.replaySpeed);
+
+  double fps = opts.fps;
+  if (fps <= 0)
+    fps = isRaw ? raw.fps() : cap.get(cv::CAP_PROP_FPS);
+  if (fps <= 0)
+    fps = 30;
+  // converting a file: keep every frame, stamped by its place in the file
+  Recorder *captureRec = startCaptureRecorder(opts, fps, true);
+
+  cv::VideoWriter writer;
+  cv::Mat frame, displayFrame, bgr;
+  EffectState state;
+  long frames = 0;
+  bool failed = false;
+
+  bool threaded = opts.pipeline.workers > 0;
+  FramePipeline pipeline(opts.pipeline);
+  MetricsDumper *metrics = nullptr;
+  if (!opts.metricsPath.empty())
+    metrics = new MetricsDumper(opts.metricsPath, opts.metricsEvery);
+  MetricsWindow hudWindow;
+  auto lastHud = std::chrono::steady_clock::now();
+
+  std::cout << "Headless: " << opts.input << " mode " << opts.mode;
+  if (isRaw)
+    std::cout << " (" << raw.frames() << " raw frames)";
+  std::cout << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  if (threaded) {
+    pipeline.recordCapture(captureRec, fps);
+    if (isRaw)
+      pipeline.start(replay, raw.size(), opts.mode);
+    else
+      pipeline.start(cap, opts.mode);
+  }
+
+  for (;;) {
+    if (threaded) {
+      if (!pipeline.next(displayFrame))
+        break;
+    } else {
+      {
+        ScopedTimer timer(Stage::Capture);
+        if (isRaw) {
+          if (!replay.next(frame))
+            frame.release();
+        } else {
+          cap >> frame;
+        }
+      }
+      if (frame.empty())
+        break;
+      if (captureRec)
+        captureRec->addFrame(frame, (int64_t)(frames * 1e6 / fps));
+      applyEffect(opts.mode, frame, displayFrame, state);
+    }
+
+    if (opts.hud) {
+      if (std::chrono::steady_clock::now() - lastHud >
+          std::chrono::milliseconds(500)) {
+        hudWindow.update();
+        lastHud = std::chrono::steady_clock::now();
+      }
+      drawMetricsHud(displayFrame, hudWindow);
+    }
+    if (metrics)
+      metrics->maybeDump();
+
+    if (!opts.output.empty()) {
+      if (!writer.isOpened()) {
+        const char *c = opts.fourcc.c_str();
+        writer.open(opts.output,
+                    cv::VideoWriter::fourcc(c[0], c[1], c[2], c[3]), fps,
+                    displayFrame.size());
+        if (!writer.isOpened()) {
+          std::cerr << "Unable to open output: " << opts.output << std::endl;
+          failed = true; // still stop the threads and close the files
+          break;
+        }
+      }
+      ScopedTimer timer(Stage::Encode);
+      writer.write(asBgr(displayFrame, bgr));
+    }
+    frames++;
+  }
+  if (metrics) {
+    metrics->dump();
+    delete metrics;
+  }
+
+  pipeline.stop();
+  writer.release();
+  stopCaptureRecorder(captureRec);
+  if (failed)
+    return -1;
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  std::cout << "Processed " << frames << " frames in " << secs << " s ("
+            << (secs > 0 ? frames / secs : 0) << " fps)" << std::endl;
+  if (threaded)
+    std::cout << "Pipeline: " << pipeline.queueDepths() << std::endl;
+  else if (state.faceTracker.frames() > 0)
+    std::cout << "Face detection: " << state.faceTracker.fullDetections()
+              << " full, " << state.faceTracker.roiDetections()
+              << " window, over " << state.faceTracker.frames() << " frames"
+              << std::endl;
+  return frames > 0 ? 0 : -1;
+}
+
+// Filters every --stream input on one shared worker pool until they end
+static int runServer(const Options &opts) {
+  int workers = opts.pipeline.workers;
+  if (workers <= 0)
+    workers = std::max(1, (int)std::thread::hardware_concurrency());
+  if (opts.depthBatch > 1)
+    setDepthBatching(opts.depthBatch, opts.depthBatchWait);
+
+  StreamServer server(workers, opts.pipeline.queueDepth);
+  for (const auto &cfg : opts.streams) {
+    if (server.addStream(cfg) < 0)
+      return -1;
+  }
+  std::cout << "Serving " << opts.streams.size() << " streams on " << workers
+            << " workers" << std::endl;
+
+  MetricsDumper *metrics = nullptr;
+  if (!opts.metricsPath.empty())
+    metrics = new MetricsDumper(opts.metricsPath, opts.metricsEvery);
+
+  auto start = std::chrono::steady_clock::now();
+  auto lastReport = start;
+  server.start();
+  while (!server.finished()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (metrics)
+      metrics->maybeDump();
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastReport > std::chrono::seconds(2)) {
+      std::cout << server.stats();
+      lastReport = now;
+    }
+    if (opts.seconds > 0 &&
+        std::chrono::duration<double>(now - start).count() > opts.seconds)
+      break;
+  }
+  server.stop();
+  std::cout << server.stats();
+  if (metrics) {
+    metrics->dump();
+    delete metrics;
+  }
+  return 0;
+}
+
+static int runLive(const Options &opts) {
   cv::VideoCapture *capdev = new cv::VideoCapture(0);
 
   // Retry for macOS permission dialog
@@ -64,110 +714,134 @@ int main(int argc, char *argv[]) {
             << std::endl;
 
   cv::namedWindow("Video", cv::WINDOW_AUTOSIZE);
-  std::cout << "Keys: q=quit s=save c/g/h/p/b/x/y/m/l/f/1/2/3/d/4=filters"
+  // camera rate unless --record-fps was given
+  RecorderConfig recCfg = opts.recorder;
+  if (recCfg.fps <= 0)
+    recCfg.fps = capdev->get(cv::CAP_PROP_FPS);
+  Recorder recorder(recCfg);
+  recorder.start();
+  if (opts.record)
+    recorder.setRecording(true);
+  // camera frames are stamped with their capture time
+  Recorder *captureRec = startCaptureRecorder(opts, recCfg.fps, false);
+
+  std::cout << "Keys: q=quit s=save r=record i=timings "
+               "c/g/h/p/b/x/y/m/l/f/1/2/3/d/4/k/5-9=filters"
             << std::endl;
 
-  cv::Mat frame, displayFrame, depthMap, grey, sobelX, sobelY;
-  std::vector<cv::Rect> faces;
-  int screenshotCounter = 0;
-  char mode = 'c';
+  cv::Mat frame, displayFrame;
+  EffectState state;
+  char mode = opts.mode;
 
-  for (;;) {
-    *capdev >> frame;
-    if (frame.empty())
-      break;
+  // Threaded: capture and filters run ahead while this thread displays
+  bool threaded = opts.pipeline.workers > 0;
+  FramePipeline pipeline(opts.pipeline);
+  if (threaded) {
+    pipeline.recordCapture(captureRec, 0);
+    pipeline.start(*capdev, mode);
+  }
+  auto lastReport = std::chrono::steady_clock::now();
 
-    switch (mode) {
-    case 'c':
-      displayFrame = frame.clone();
-      break;
-    case 'g':
-      cv::cvtColor(frame, displayFrame, cv::COLOR_BGR2GRAY);
-      cv::cvtColor(displayFrame, displayFrame, cv::COLOR_GRAY2BGR);
-      break;
-    case 'h':
-      greyscale(frame, displayFrame);
-      break;
-    case 'p':
-      sepia(frame, displayFrame);
-      break;
-    case 'b':
-      blur5x5_2(frame, displayFrame);
-      break;
-    case 'x':
-      sobelX3x3(frame, sobelX);
-      cv::convertScaleAbs(sobelX, displayFrame);
-      break;
-    case 'y':
-      sobelY3x3(frame, sobelY);
-      cv::convertScaleAbs(sobelY, displayFrame);
-      break;
-    case 'm':
-      sobelX3x3(frame, sobelX);
-      sobelY3x3(frame, sobelY);
-      magnitude(sobelX, sobelY, displayFrame);
-      break;
-    case 'l':
-      blurQuantize(frame, displayFrame, 10);
-      break;
-    case 'f':
-      displayFrame = frame.clone();
-      cv::cvtColor(frame, grey, cv::COLOR_BGR2GRAY);
-      detectFaces(grey, faces);
-      drawBoxes(displayFrame, faces);
-      break;
-    case '1':
-      cv::cvtColor(frame, grey, cv::COLOR_BGR2GRAY);
-      detectFaces(grey, faces);
-      spotlight(frame, displayFrame, faces);
-      break;
-    case '2':
-      neonEdges(frame, displayFrame);
-      break;
-    case '3':
-      cartoon(frame, displayFrame, 10);
-      break;
-    case 'd':
-      if (ensureDepthNetwork() && depthNetwork->process(frame, depthMap)) {
-        cv::cvtColor(depthMap, displayFrame, cv::COLOR_GRAY2BGR);
-      } else {
-        displayFrame = frame.clone();
-        cv::putText(displayFrame, "Depth model not loaded", cv::Point(10, 30),
-                    cv::FONT_HERSHEY_SIMPLEX, 1, cv::Scalar(0, 0, 255), 2);
+  bool hud = opts.hud;
+  MetricsWindow hudWindow;
+  auto lastHud = lastReport;
+  MetricsDumper *metrics = nullptr;
+  if (!opts.metricsPath.empty())
+    metrics = new MetricsDumper(opts.metricsPath, opts.metricsEvery);
+
+  for (;;) {
+    if (threaded) {
+      if (!pipeline.next(displayFrame))
+        break;
+    } else {
+      {
+        ScopedTimer timer(Stage::Capture);
+        *capdev >> frame;
       }
-      break;
-    case '4':
-      if (ensureDepthNetwork() && depthNetwork->process(frame, depthMap)) {
-        digitalFog(frame, depthMap, displayFrame);
-      } else {
-        displayFrame = frame.clone();
-        cv::putText(displayFrame, "Depth model not loaded", cv::Point(10, 30),
-                    cv::FONT_HERSHEY_SIMPLEX, 1, cv::Scalar(0, 0, 255), 2);
+      if (frame.empty())
+        break;
+      if (captureRec)
+        captureRec->addFrame(frame);
+      applyEffect(mode, frame, displayFrame, state);
+    }
+
+    if (hud) {
+      // refresh twice a second so the numbers are readable
+      if (std::chrono::steady_clock::now() - lastHud >
+          std::chrono::milliseconds(500)) {
+        hudWindow.update();
+        lastHud = std::chrono::steady_clock::now();
       }
-      break;
-    default:
-      displayFrame = frame.clone();
-      break;
+      drawMetricsHud(displayFrame, hudWindow);
     }
+    if (metrics)
+      metrics->maybeDump();
+    recorder.addFrame(displayFrame);
 
-    cv::imshow("Video", displayFrame);
-    char key = cv::waitKey(10);
+    char key;
+    {
+      ScopedTimer timer(Stage::Display);
+      cv::imshow("Video", displayFrame);
+      key = cv::waitKey(threaded ? 1 : 10);
+    }
+
+    if (threaded && std::chrono::steady_clock::now() - lastReport >
+                        std::chrono::seconds(2)) {
+      std::cout << pipeline.queueDepths() << std::endl;
+      lastReport = std::chrono::steady_clock::now();
+    }
 
     if (key == 'q' || key == 'Q')
       break;
+    if (key == 'i') {
+      hud = !hud;
+      continue;
+    }
     if (key == 's' || key == 'S') {
-      std::string filename = "../data/screenshot_" +
-                             std::to_string(std::time(nullptr)) + "_" +
-                             std::to_string(screenshotCounter++) + ".png";
-      cv::imwrite(filename, displayFrame);
-      std::cout << "Saved: " << filename << std::endl;
-    } else if (std::string("cghpbxymlf1234d").find(key) != std::string::npos) {
+      // written by the recorder thread, which prints "Saved:"
+      if (recorder.snapshot(displayFrame).empty())
+        std::cerr << "Snapshot dropped, recorder queue full" << std::endl;
+    } else if (key == 'r' || key == 'R') {
+      recorder.setRecording(!recorder.recording());
+    } else if (isEffectKey(key)) {
       mode = key;
+      pipeline.setMode(mode);
       std::cout << "Mode: " << mode << std::endl;
     }
   }
 
+  pipeline.stop();
+  recorder.stop();
+  std::cout << recorder.stats() << std::endl;
+  stopCaptureRecorder(captureRec);
+  delete metrics;
   delete capdev;
   cv::destroyAllWindows();
   return 0;
 }
+
+int main(int argc, char *argv[]) {
+  Options opts;
+  if (!parseArgs(std::vector<std::string>(argv + 1, argv + argc), opts)) {
+    usage(argv[0]);
+    return -1;
+  }
+  setDepthConfig(opts.depthConfig);
+  setFaceDetectorConfig(opts.faceConfig);
+  setTemporalConfig(opts.temporal);
+  setFogStyle(opts.fog);
+  if (opts.dirtyTiles)
+    setDirtyTiles(opts.dirty);
+  if (opts.depthBench)
+    return runDepthBench(opts.depthConfig);
+  if (opts.asyncDepth)
+    setAsyncDepth(opts.depthPolicy);
+
+  int ret;
+  if (!opts.streams.empty())
+    ret = runServer(opts);
+  else
+    ret = !opts.input.empty() ? runHeadless(opts) : runLive(opts);
+  shutdownEffects();
+  return ret;
+}